@@ -43,6 +43,7 @@
 #include <librnd/hid/tool.h>
 #include "layer.h"
 #include "netlist.h"
+#include "find.h"
 
 pcb_board_t *PCB;
 
@@ -55,6 +56,7 @@ void pcb_board_free(pcb_board_t * pcb)
 	if (pcb == NULL)
 		return;
 
+	pcb_find_island_flush();
 	free(pcb->line_mod_merge);
 	free(pcb->hidlib.name);
 	free(pcb->hidlib.loadname);
@@ -387,8 +389,10 @@ void pcb_board_set_changed_flag(pcb_board_t *pcb, rnd_bool New)
 	if (old != New)
 		rnd_event(&pcb->hidlib, RND_EVENT_DESIGN_META_CHANGED, NULL);
 
-	if (New)
+	if (New) {
+		pcb->edit_serial++;
 		rnd_event(&pcb->hidlib, PCB_EVENT_BOARD_EDITED, NULL);
+	}
 }
 
 
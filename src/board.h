@@ -68,6 +68,7 @@ struct pcb_board_s {
 	char *Netlistname;                              /* name of netlist file */
 
 	rnd_bool Changed;                               /* layout has been changed */
+	unsigned long edit_serial;                      /* incremented each time the board is marked changed and on each undo/redo */
 
 	rnd_bool pstk_on, RatOn, InvisibleObjectsOn,
 	         SubcOn, SubcPartsOn,
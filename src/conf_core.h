@@ -178,6 +178,7 @@ typedef struct {
 		} drc_disable;
 
 		RND_CFT_REAL poly_isle_area;           /* polygon island mininum area used to throw out islands too small in MorphPolygon; specified in nm^2; note: due to historical bugs, half or double of the value may be used by the code. */
+		RND_CFT_INTEGER poly_clip_tiles;       /* when clipping a whole polygon, first unite the clearances in this many by this many tiles over the polygon's bounding box, then cut the polygon once; 0 means no tiling (clearances are united pairwise in batches) */
 		RND_CFT_STRING fab_author;             /* Full name of author for FAB drawings */
 		RND_CFT_STRING initial_layer_stack;    /* deprecated. */
 
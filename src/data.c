@@ -30,6 +30,8 @@
 #include "config.h"
 
 #include <time.h>
+#include <genht/htpp.h>
+#include <genht/hash.h>
 
 #include "board.h"
 #include "data.h"
@@ -907,6 +909,126 @@ void pcb_data_clip_all(pcb_data_t *data, rnd_bool enable_progbar)
 	pcb_data_clip_all_poly(data, enable_progbar, rnd_true);
 }
 
+/*** rtree repack ***/
+
+#define REPACK_HILBERT_ORDER 16
+
+typedef struct {
+	unsigned long key;
+	void *obj;
+} data_repack_t;
+
+static int data_repack_cmp(const void *a_, const void *b_)
+{
+	const data_repack_t *a = a_, *b = b_;
+	if (a->key < b->key) return -1;
+	if (a->key > b->key) return 1;
+	return 0;
+}
+
+/* Distance of (x;y) along a Hilbert curve that covers a 2^ORDER by 2^ORDER
+   grid; objects close on the curve are close on the board */
+static unsigned long data_repack_hilbert(unsigned long x, unsigned long y)
+{
+	unsigned long s, rx, ry, t, d = 0, n = 1UL << REPACK_HILBERT_ORDER;
+
+	for(s = n/2; s > 0; s /= 2) {
+		rx = (x & s) > 0;
+		ry = (y & s) > 0;
+		d += s * s * ((3 * rx) ^ ry);
+		if (ry == 0) {
+			if (rx == 1) {
+				x = n-1 - x;
+				y = n-1 - y;
+			}
+			t = x; x = y; y = t;
+		}
+	}
+	return d;
+}
+
+/* Rebuild a tree inserting objects in Hilbert order of their bbox centers */
+static void data_rtree_repack(rnd_rtree_t *tree)
+{
+	rnd_rtree_it_t it;
+	rnd_box_t *b;
+	data_repack_t *ent;
+	long n, len = 0;
+	rnd_coord_t x1 = RND_MAX_COORD, y1 = RND_MAX_COORD, x2 = -RND_MAX_COORD, y2 = -RND_MAX_COORD;
+	double sx, sy, grid = (double)((1UL << REPACK_HILBERT_ORDER) - 1);
+
+	if (tree->size < 3)
+		return;
+
+	ent = malloc(sizeof(data_repack_t) * tree->size);
+	for(b = rnd_rtree_all_first(&it, tree); (b != NULL) && (len < tree->size); b = rnd_rtree_all_next(&it)) {
+		rnd_coord_t cx = b->X1/2 + b->X2/2, cy = b->Y1/2 + b->Y2/2;
+		if (cx < x1) x1 = cx;
+		if (cy < y1) y1 = cy;
+		if (cx > x2) x2 = cx;
+		if (cy > y2) y2 = cy;
+		ent[len++].obj = b;
+	}
+
+	sx = (x2 > x1) ? grid / ((double)x2 - (double)x1) : 0;
+	sy = (y2 > y1) ? grid / ((double)y2 - (double)y1) : 0;
+	for(n = 0; n < len; n++) {
+		b = ent[n].obj;
+		ent[n].key = data_repack_hilbert(
+			(unsigned long)(((double)(b->X1/2 + b->X2/2) - (double)x1) * sx),
+			(unsigned long)(((double)(b->Y1/2 + b->Y2/2) - (double)y1) * sy));
+	}
+	qsort(ent, len, sizeof(data_repack_t), data_repack_cmp);
+
+	rnd_rtree_uninit(tree);
+	rnd_rtree_init(tree);
+	for(n = 0; n < len; n++)
+		rnd_rtree_insert(tree, ent[n].obj, (rnd_rtree_box_t *)ent[n].obj);
+
+	free(ent);
+}
+
+/* Trees are shared between the board and bound subcircuit layers; each
+   tree is repacked only once */
+static void data_rtree_repack_tree(htpp_t *done, rnd_rtree_t *tree)
+{
+	if ((tree == NULL) || htpp_has(done, tree))
+		return;
+	htpp_set(done, tree, tree);
+	data_rtree_repack(tree);
+}
+
+static void data_rtree_repack_data(htpp_t *done, pcb_data_t *data)
+{
+	rnd_layer_id_t lid;
+
+	data_rtree_repack_tree(done, data->padstack_tree);
+	data_rtree_repack_tree(done, data->subc_tree);
+	data_rtree_repack_tree(done, data->rat_tree);
+
+	for(lid = 0; lid < data->LayerN; lid++) {
+		pcb_layer_t *ly = data->Layer + lid;
+		data_rtree_repack_tree(done, ly->line_tree);
+		data_rtree_repack_tree(done, ly->arc_tree);
+		data_rtree_repack_tree(done, ly->text_tree);
+		data_rtree_repack_tree(done, ly->polygon_tree);
+		data_rtree_repack_tree(done, ly->gfx_tree);
+	}
+
+	PCB_SUBC_LOOP(data); {
+		data_rtree_repack_data(done, subc->data);
+	} PCB_END_LOOP;
+}
+
+void pcb_data_rtree_repack(pcb_data_t *data)
+{
+	htpp_t done;
+
+	htpp_init(&done, ptrhash, ptrkeyeq);
+	data_rtree_repack_data(&done, data);
+	htpp_uninit(&done);
+}
+
 
 void pcb_data_flag_change(pcb_data_t *data, pcb_objtype_t mask, int how, unsigned long flags)
 {
@@ -223,6 +223,12 @@ void pcb_data_clip_dirty(pcb_data_t *data, rnd_bool enable_progbar);
    of operation (e.g. autocrop()) */
 void pcb_data_clip_all(pcb_data_t *data, rnd_bool enable_progbar);
 
+/* Rebuild all rtrees of data, recursively, inserting objects in spatial
+   (Hilbert curve) order. Object-by-object insertion in file order, as
+   loaders do, yields deeper trees with more overlap; loaders call this
+   once the board is in memory, before poly clipping. */
+void pcb_data_rtree_repack(pcb_data_t *data);
+
 
 /* Recursively change flags of data; how is one of pcb_change_flag_t */
 void pcb_data_flag_change(pcb_data_t *data, pcb_objtype_t mask, int how, unsigned long flags);
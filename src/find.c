@@ -36,6 +36,7 @@ const pcb_find_t pcb_find0_, *pcb_find0 = &pcb_find0_;
 
 #include "find_geo.c"
 #include "find_any_isect.c"
+#include "find_island.c"
 
 /* Multimark flags for a given object. This struct is used to store
    partial marks for objects that have multiple independently connected
@@ -471,6 +472,183 @@ static void pcb_find_rat(pcb_find_t *ctx, pcb_rat_t *rat)
 	pcb_find_on_layergrp(ctx, pcb_get_layergrp(ctx->pcb, rat->group2), (pcb_any_obj_t *)rat, &sb, PCB_FCT_RAT);
 }
 
+/*** connectivity cache ***/
+
+/* Galvanic neighbours of objects, remembered between pcb_find_cache_begin()
+   and pcb_find_cache_end() */
+typedef struct {
+	vtp0_t objs;  /* of (pcb_any_obj_t *): every object curr intersects with, in the order the uncached search would find them */
+	long npstk;   /* the first npstk items of objs are padstacks, the rest are layer objects */
+} pcb_find_cache_nb_t;
+
+static struct {
+	pcb_board_t *pcb;
+	int nest;
+	htpp_t nb;    /* key: (pcb_any_obj_t *) curr; value: (pcb_find_cache_nb_t *) */
+} find_cache;
+
+void pcb_find_cache_begin(pcb_board_t *pcb)
+{
+	if (find_cache.nest > 0) {
+		if (find_cache.pcb == pcb)
+			find_cache.nest++;
+		else
+			rnd_message(RND_MSG_ERROR, "pcb_find_cache_begin(): cache already in use for another board\n");
+		return;
+	}
+
+	find_cache.pcb = pcb;
+	find_cache.nest = 1;
+	htpp_init(&find_cache.nb, ptrhash, ptrkeyeq);
+}
+
+void pcb_find_cache_end(pcb_board_t *pcb)
+{
+	if ((find_cache.nest <= 0) || (find_cache.pcb != pcb))
+		return;
+
+	find_cache.nest--;
+	if (find_cache.nest > 0)
+		return;
+
+	genht_uninit_deep(htpp, &find_cache.nb, {
+		pcb_find_cache_nb_t *nb = htent->value;
+		vtp0_uninit(&nb->objs);
+		free(nb);
+	});
+	find_cache.pcb = NULL;
+}
+
+/* The cache is built using the default (all-zero) intersection config and
+   the default high level search; any non-default config that affects which
+   objects connect bypasses the cache */
+RND_INLINE int find_cache_usable(pcb_find_t *ctx)
+{
+	return (find_cache.nest > 0) && (ctx->pcb == find_cache.pcb) && (ctx->pcb == PCB) && (ctx->data == ctx->pcb->Data)
+		&& (ctx->bloat == 0) && !ctx->ignore_clearance && !ctx->allow_noncopper_pstk && !ctx->pstk_anylayer
+		&& !ctx->stay_layergrp && !ctx->allow_noncopper;
+}
+
+#define FIND_CACHE_CHECK(curr, obj) \
+	do { \
+		pcb_any_obj_t *__obj__ = (pcb_any_obj_t *)obj; \
+		if ((__obj__ != curr) && !INOCONN(curr, __obj__) && (pcb_intersect_obj_obj(pcb_find0, curr, __obj__))) \
+			vtp0_append(&nb->objs, __obj__); \
+	} while(0)
+
+static void find_cache_collect_on_layer(pcb_find_cache_nb_t *nb, pcb_layer_t *l, pcb_any_obj_t *curr, rnd_rtree_box_t *sb)
+{
+	rnd_rtree_it_t it;
+	rnd_box_t *n;
+
+	if (l->line_tree != NULL)
+		for(n = rnd_rtree_first(&it, l->line_tree, sb); n != NULL; n = rnd_rtree_next(&it))
+			FIND_CACHE_CHECK(curr, n);
+
+	if (l->arc_tree != NULL)
+		for(n = rnd_rtree_first(&it, l->arc_tree, sb); n != NULL; n = rnd_rtree_next(&it))
+			FIND_CACHE_CHECK(curr, n);
+
+	if (l->polygon_tree != NULL)
+		for(n = rnd_rtree_first(&it, l->polygon_tree, sb); n != NULL; n = rnd_rtree_next(&it))
+			FIND_CACHE_CHECK(curr, n);
+
+	if (l->text_tree != NULL)
+		for(n = rnd_rtree_first(&it, l->text_tree, sb); n != NULL; n = rnd_rtree_next(&it))
+			FIND_CACHE_CHECK(curr, n);
+}
+
+/* Return the neighbours of a non-rat curr, computing them on first call;
+   mirrors the search of pcb_find_exec(), but without the found-mark
+   filtering (that's done when the list is used) */
+static pcb_find_cache_nb_t *find_cache_get(pcb_find_t *ctx, pcb_any_obj_t *curr)
+{
+	pcb_find_cache_nb_t *nb = htpp_get(&find_cache.nb, curr);
+	rnd_rtree_box_t *sb = (rnd_rtree_box_t *)&curr->bbox_naked;
+	pcb_data_t *data = ctx->data;
+	rnd_rtree_it_t it;
+	rnd_box_t *n;
+
+	if (nb != NULL)
+		return nb;
+
+	nb = calloc(sizeof(pcb_find_cache_nb_t), 1);
+
+	if (data->padstack_tree != NULL)
+		for(n = rnd_rtree_first(&it, data->padstack_tree, sb); n != NULL; n = rnd_rtree_next(&it))
+			FIND_CACHE_CHECK(curr, n);
+	nb->npstk = nb->objs.used;
+
+	if (curr->type == PCB_OBJ_PSTK) {
+		int li;
+		pcb_layer_t *l;
+		pcb_pstk_proto_t *proto = pcb_pstk_get_proto((const pcb_pstk_t *)curr);
+		for(li = 0, l = data->Layer; li < data->LayerN; li++,l++) {
+			if (!(pcb_layer_flags_(l) & PCB_LYT_COPPER))
+				continue;
+			if (pcb_pstk_shape_at_(ctx->pcb, (pcb_pstk_t *)curr, l, 0))
+				find_cache_collect_on_layer(nb, l, curr, sb);
+			else if (proto->hplated) { /* consider plated slots */
+				pcb_layer_t *rl = pcb_layer_get_real(l);
+				if (pcb_pstk_bb_drills(ctx->pcb, (const pcb_pstk_t *)curr, rl->meta.real.grp, NULL))
+					find_cache_collect_on_layer(nb, l, curr, sb);
+			}
+		}
+	}
+	else {
+		pcb_layergrp_t *g;
+		assert(curr->parent_type == PCB_PARENT_LAYER);
+		g = pcb_get_layergrp(ctx->pcb, pcb_layer_get_group_(curr->parent.layer));
+		if (g != NULL) { /* g==NULL for inbound subc layers */
+			int li;
+			for(li = 0; li < g->len; li++)
+				find_cache_collect_on_layer(nb, &data->Layer[g->lid[li]], curr, sb);
+		}
+	}
+
+	htpp_set(&find_cache.nb, curr, nb);
+	return nb;
+}
+
+/* Add a cached neighbour to the search if it's not yet found */
+#define FIND_CACHE_ADD(ctx, curr, obj, ctype, retstmt) \
+	do { \
+		pcb_any_obj_t *__obj__ = (obj); \
+		if (!pcb_find_mark_get(ctx, __obj__, (curr))) { \
+			if (pcb_find_addobj(ctx, __obj__, curr, ctype, 1) != 0) { retstmt; } \
+			if ((__obj__->term != NULL) && (!ctx->ignore_intconn) && (__obj__->intconn > 0)) \
+				find_int_conn(ctx, __obj__); \
+		} \
+	} while(0)
+
+/* Cached version of the search step of pcb_find_exec() for a non-rat curr;
+   returns non-zero if pcb_find_exec() needs to return immediately */
+static int find_cache_exec_obj(pcb_find_t *ctx, pcb_any_obj_t *curr, pcb_found_conn_type_t ctype)
+{
+	pcb_find_cache_nb_t *nb = find_cache_get(ctx, curr);
+	long i;
+
+	for(i = 0; i < nb->npstk; i++)
+		FIND_CACHE_ADD(ctx, curr, nb->objs.array[i], ctype, return 1);
+
+	/* rats are not cached: they are cheap and get created while rats are being optimized */
+	if ((ctx->consider_rats || ctx->only_mark_rats) && (ctx->data->rat_tree != NULL)) {
+		rnd_rtree_it_t it;
+		rnd_box_t *n;
+		for(n = rnd_rtree_first(&it, ctx->data->rat_tree, (rnd_rtree_box_t *)&curr->bbox_naked); n != NULL; n = rnd_rtree_next(&it))
+			PCB_FIND_CHECK_RAT(ctx, curr, n, PCB_FCT_RAT, return 1);
+	}
+
+	for(; i < nb->objs.used; i++) {
+		pcb_any_obj_t *o = nb->objs.array[i];
+		if ((curr->type == PCB_OBJ_PSTK) && !pcb_find_mark_get_pstk_on_layer(ctx, curr, o->parent.layer))
+			continue; /* padstack is not really found on this specific layer (it is marked found on other layers) */
+		FIND_CACHE_ADD(ctx, curr, o, ctype, return 0);
+	}
+
+	return 0;
+}
+
 static unsigned long pcb_find_exec(pcb_find_t *ctx)
 {
 	pcb_any_obj_t *curr;
@@ -493,6 +671,12 @@ static unsigned long pcb_find_exec(pcb_find_t *ctx)
 		curr = ctx->open.array[ctx->open.used];
 		ctype = curr->type == PCB_OBJ_RAT ? PCB_FCT_RAT : PCB_FCT_COPPER;
 
+		if ((curr->type != PCB_OBJ_RAT) && find_cache_usable(ctx)) {
+			if (find_cache_exec_obj(ctx, curr, ctype) != 0)
+				return ctx->nfound;
+			continue;
+		}
+
 		{ /* search unmkared connections: iterative approach */
 			rnd_rtree_it_t it;
 			rnd_box_t *n;
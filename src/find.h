@@ -110,6 +110,36 @@ unsigned long pcb_find_from_obj_next(pcb_find_t *ctx, pcb_data_t *data, pcb_any_
 
 void pcb_find_free(pcb_find_t *ctx);
 
+/* Connectivity cache: between begin and end the caller guarantees the
+   copper geometry of the board is not changed (object flags may change,
+   rats may be added); searches with the default config then remember the
+   galvanic neighbours of each object they visit and later searches reuse
+   them instead of redoing the intersection tests. Calls can be nested. */
+void pcb_find_cache_begin(pcb_board_t *pcb);
+void pcb_find_cache_end(pcb_board_t *pcb);
+
+/*** copper island index ***/
+
+/* A galvanically connected set of copper objects (rats are ignored) */
+typedef struct pcb_find_island_s {
+	long id;                      /* unique within the index */
+	vtp0_t objs;                  /* of (pcb_any_obj_t *): all objects of the island */
+	pcb_any_obj_t *best_term;     /* terminal object with the lowest ID, or NULL if the island has no terminal */
+	pcb_any_obj_t *best_nonterm;  /* non-terminal object with the lowest ID, or NULL */
+} pcb_find_island_t;
+
+/* Return the island obj is part of, mapping the island on first call. The
+   result is valid until the next board change. Returns NULL for objects
+   that can not be indexed: non-copper objects and padstacks with disjoint
+   copper shapes (these may be part of multiple islands) */
+pcb_find_island_t *pcb_find_island(pcb_board_t *pcb, pcb_any_obj_t *obj);
+
+/* Returns 1 if a and b are galvanically connected (rats ignored) */
+int pcb_find_same_island(pcb_board_t *pcb, pcb_any_obj_t *a, pcb_any_obj_t *b);
+
+/* Drop the island index; called by the undo code on every board change */
+void pcb_find_island_flush(void);
+
 /* High level intersection function: returns if a and b intersect (overlap) */
 rnd_bool pcb_intersect_obj_obj(const pcb_find_t *ctx, pcb_any_obj_t *a, pcb_any_obj_t *b);
 
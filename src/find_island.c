@@ -0,0 +1,163 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  pcb-rnd, interactive printed circuit board design
+ *  Copyright (C) 2024 Tibor 'Igor2' Palinkas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  Contact:
+ *    Project page: http://repo.hu/projects/pcb-rnd
+ *    lead developer: http://repo.hu/projects/pcb-rnd/contact.html
+ *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
+ */
+
+/* Copper island index: maps copper objects to the galvanically connected
+   island (network segment) they are part of. Islands are disjoint sets of
+   objects; each island is mapped by a single find, on the first query of
+   any of its objects. Any board change drops the whole index; islands are
+   then re-mapped lazily, only when queried again. */
+
+static struct {
+	pcb_board_t *pcb;
+	htpp_t obj2isl;    /* key: (pcb_any_obj_t *); value: (pcb_find_island_t *) */
+	vtp0_t islands;    /* of (pcb_find_island_t *), in order of mapping */
+	unsigned inited:1;
+} find_isl;
+
+/* Only copper objects of the board are indexed (buffer objects are not
+   tracked by undo). Padstacks with disjoint copper shapes may be part of
+   multiple islands. */
+static int find_island_indexable(pcb_board_t *pcb, pcb_any_obj_t *obj)
+{
+	pcb_pstk_proto_t *proto;
+
+	switch(obj->type) {
+		case PCB_OBJ_PSTK:
+			if ((obj->parent_type != PCB_PARENT_DATA) || (pcb_data_get_top(obj->parent.data) != pcb))
+				return 0;
+			proto = pcb_pstk_get_proto((pcb_pstk_t *)obj);
+			return (proto == NULL) || proto->all_copper_connd || (((pcb_pstk_t *)obj)->term != NULL);
+		case PCB_OBJ_LINE:
+		case PCB_OBJ_ARC:
+		case PCB_OBJ_POLY:
+		case PCB_OBJ_TEXT:
+		case PCB_OBJ_GFX:
+			if ((obj->parent_type != PCB_PARENT_LAYER) || (pcb_layer_get_top(obj->parent.layer) != pcb))
+				return 0;
+			return !!(pcb_layer_flags_(obj->parent.layer) & PCB_LYT_COPPER);
+		default:
+			break;
+	}
+	return 0;
+}
+
+void pcb_find_island_flush(void)
+{
+	long n;
+
+	if (!find_isl.inited)
+		return;
+
+	for(n = 0; n < find_isl.islands.used; n++) {
+		pcb_find_island_t *isl = find_isl.islands.array[n];
+		vtp0_uninit(&isl->objs);
+		free(isl);
+	}
+	vtp0_uninit(&find_isl.islands);
+	htpp_uninit(&find_isl.obj2isl);
+	find_isl.pcb = NULL;
+	find_isl.inited = 0;
+}
+
+static int find_island_found_cb(pcb_find_t *fctx, pcb_any_obj_t *new_obj, pcb_any_obj_t *arrived_from, pcb_found_conn_type_t ctype)
+{
+	pcb_find_island_t *isl = fctx->user_data;
+
+	vtp0_append(&isl->objs, new_obj);
+
+	if (new_obj->term != NULL) {
+		if ((isl->best_term == NULL) || (new_obj->ID < isl->best_term->ID))
+			isl->best_term = new_obj;
+	}
+	else {
+		if ((isl->best_nonterm == NULL) || (new_obj->ID < isl->best_nonterm->ID))
+			isl->best_nonterm = new_obj;
+	}
+
+	if (find_island_indexable(find_isl.pcb, new_obj))
+		htpp_set(&find_isl.obj2isl, new_obj, isl);
+
+	return 0;
+}
+
+pcb_find_island_t *pcb_find_island(pcb_board_t *pcb, pcb_any_obj_t *obj)
+{
+	pcb_find_island_t *isl;
+	pcb_find_t fctx;
+
+	if (!find_island_indexable(pcb, obj))
+		return NULL;
+
+	if (find_isl.inited && (find_isl.pcb != pcb))
+		pcb_find_island_flush();
+
+	if (!find_isl.inited) {
+		htpp_init(&find_isl.obj2isl, ptrhash, ptrkeyeq);
+		vtp0_init(&find_isl.islands);
+		find_isl.pcb = pcb;
+		find_isl.inited = 1;
+	}
+	else {
+		isl = htpp_get(&find_isl.obj2isl, obj);
+		if (isl != NULL)
+			return isl;
+	}
+
+	isl = calloc(sizeof(pcb_find_island_t), 1);
+	isl->id = find_isl.islands.used;
+	vtp0_append(&find_isl.islands, isl);
+
+	/* default config: copper only, rats ignored */
+	memset(&fctx, 0, sizeof(fctx));
+	fctx.user_data = isl;
+	fctx.found_cb = find_island_found_cb;
+	pcb_find_from_obj(&fctx, pcb->Data, obj);
+	pcb_find_free(&fctx);
+
+	return isl;
+}
+
+int pcb_find_same_island(pcb_board_t *pcb, pcb_any_obj_t *a, pcb_any_obj_t *b)
+{
+	pcb_find_island_t *ia, *ib;
+	pcb_find_t fctx;
+	int res;
+
+	if (a == b)
+		return 1;
+
+	ia = pcb_find_island(pcb, a);
+	ib = pcb_find_island(pcb, b);
+	if ((ia != NULL) && (ib != NULL))
+		return ia == ib;
+
+	/* at least one of them is not indexed: fall back to searching from a */
+	memset(&fctx, 0, sizeof(fctx));
+	pcb_find_from_obj(&fctx, pcb->Data, a);
+	res = PCB_FIND_IS_MARKED(&fctx, b);
+	pcb_find_free(&fctx);
+	return !!res;
+}
@@ -471,14 +471,43 @@ int pcb_net_del(pcb_netlist_t *nl, const char *netname)
 	return 0;
 }
 
+/* Look up the copper object of a netlist terminal; same as
+   pcb_term_find_name(), but uses the refdes index of sctx instead of a
+   linear search over all subcircuits of the board */
+static pcb_any_obj_t *short_ctx_term_find(pcb_short_ctx_t *sctx, const char *refdes, const char *term)
+{
+	pcb_subc_t *sc;
+
+	if (!sctx->refdes_inited) {
+		htsp_init(&sctx->refdes, strhash, strkeyeq);
+		PCB_SUBC_LOOP(sctx->pcb->Data);
+		{
+			/* first match wins, just like in pcb_subc_by_refdes() */
+			if ((subc->refdes != NULL) && !htsp_has(&sctx->refdes, (char *)subc->refdes))
+				htsp_set(&sctx->refdes, (char *)subc->refdes, subc);
+		}
+		PCB_END_LOOP;
+		sctx->refdes_inited = 1;
+	}
+
+	sc = htsp_get(&sctx->refdes, (char *)refdes);
+	if (sc == NULL)
+		return NULL;
+	return pcb_term_find_name_subc(sctx->pcb, sc, PCB_LYT_COPPER, term, NULL);
+}
+
 /* crawl from a single terminal; "first" sould be a pointer to an int
-   initialized to 0. Returns number of objects found. */
-static rnd_cardinal_t pcb_net_term_crawl(const pcb_board_t *pcb, pcb_net_term_t *term, pcb_find_t *fctx, int *first, rnd_cardinal_t *missing)
+   initialized to 0. If sctx is not NULL, its refdes index is used for
+   looking up the terminal. Returns number of objects found. */
+static rnd_cardinal_t pcb_net_term_crawl(const pcb_board_t *pcb, pcb_short_ctx_t *sctx, pcb_net_term_t *term, pcb_find_t *fctx, int *first, rnd_cardinal_t *missing)
 {
 	pcb_any_obj_t *o;
 
 /* there can be multiple terminals with the same ID, but it is enough to run find from the first: find.c will consider them all */
-	o = pcb_term_find_name(pcb, pcb->Data, PCB_LYT_COPPER, term->refdes, term->term, NULL, NULL);
+	if (sctx != NULL)
+		o = short_ctx_term_find(sctx, term->refdes, term->term);
+	else
+		o = pcb_term_find_name(pcb, pcb->Data, PCB_LYT_COPPER, term->refdes, term->term, NULL, NULL);
 	if (o == NULL) {
 		if (missing != NULL) {
 			rnd_message(RND_MSG_WARNING, "Netlist problem: terminal %s-%s is missing from the board but referenced from the netlist\n", term->refdes, term->term);
@@ -506,6 +535,7 @@ void pcb_net_short_ctx_init(pcb_short_ctx_t *sctx, const pcb_board_t *pcb, pcb_n
 	sctx->missing = 0;
 	sctx->num_shorts = 0;
 	sctx->cancel_advanced = 0;
+	sctx->refdes_inited = 0;
 	htsp_init(&sctx->found, strhash, strkeyeq);
 }
 
@@ -515,6 +545,10 @@ void pcb_net_short_ctx_uninit(pcb_short_ctx_t *sctx)
 	for(e = htsp_first(&sctx->found); e != NULL; e = htsp_next(&sctx->found, e))
 		free(e->key);
 	htsp_uninit(&sctx->found);
+	if (sctx->refdes_inited) {
+		htsp_uninit(&sctx->refdes);
+		sctx->refdes_inited = 0;
+	}
 	if (sctx->changed) {
 		rnd_gui->invalidate_all(rnd_gui);
 		conf_core.temp.rat_warn = rnd_true;
@@ -574,7 +608,7 @@ static void net_found_short(pcb_short_ctx_t *sctx, pcb_any_obj_t *offender)
 	rnd_event(&PCB->hidlib, PCB_EVENT_NET_INDICATE_SHORT, "ppppp", sctx->current_net, offender, offn, &handled, &sctx->cancel_advanced);
 	if (!handled) {
 		pcb_net_term_t *orig_t = pcb_termlist_first(&sctx->current_net->conns);
-		pcb_any_obj_t *orig_o = pcb_term_find_name(sctx->pcb, sctx->pcb->Data, PCB_LYT_COPPER, orig_t->refdes, orig_t->term, NULL, NULL);
+		pcb_any_obj_t *orig_o = short_ctx_term_find(sctx, orig_t->refdes, orig_t->term);
 
 		/* dummy fallback: warning-highlight the two terminals */
 		PCB_FLAG_SET(PCB_FLAG_WARN, offender);
@@ -626,7 +660,7 @@ rnd_cardinal_t pcb_net_crawl_flag(pcb_board_t *pcb, pcb_net_t *net, unsigned lon
 	fctx.found_cb = net_short_check;
 
 	for(t = pcb_termlist_first(&net->conns), n = 0; t != NULL; t = pcb_termlist_next(t), n++) {
-		res += pcb_net_term_crawl(pcb, t, &fctx, &first, NULL);
+		res += pcb_net_term_crawl(pcb, &sctx, t, &fctx, &first, NULL);
 	}
 
 	pcb_find_free(&fctx);
@@ -723,10 +757,10 @@ rnd_cardinal_t pcb_net_map_subnets(pcb_short_ctx_t *sctx, pcb_rat_accuracy_t acc
 {
 	pcb_find_t fctx;
 	pcb_net_term_t *t;
-	rnd_cardinal_t drawn = 0, r, n, s1, s2, su, sd;
-	pcb_subnet_dist_t *connmx;
-	char *done;
-	int left, first = 0;
+	rnd_cardinal_t drawn = 0, r, n;
+	pcb_subnet_edge_t *edges;
+	long ns, nedges, en;
+	int first = 0;
 	pcb_rat_t *line;
 
 
@@ -740,7 +774,7 @@ rnd_cardinal_t pcb_net_map_subnets(pcb_short_ctx_t *sctx, pcb_rat_accuracy_t acc
 	   objects of each subnet is collected on a vtp0_t; object-lists per subnet
 	   is saved in variable "subnets" */
 	for(t = pcb_termlist_first(&sctx->current_net->conns), n = 0; t != NULL; t = pcb_termlist_next(t), n++) {
-		r = pcb_net_term_crawl(sctx->pcb, t, &fctx, &first, &sctx->missing);
+		r = pcb_net_term_crawl(sctx->pcb, sctx, t, &fctx, &first, &sctx->missing);
 		if (r > 0) {
 			vtp0_t *objs = malloc(sizeof(vtp0_t));
 			memcpy(objs, &fctx.found, sizeof(vtp0_t));
@@ -749,52 +783,21 @@ rnd_cardinal_t pcb_net_map_subnets(pcb_short_ctx_t *sctx, pcb_rat_accuracy_t acc
 		}
 	}
 
-	/* find the shortest connection between any two subnets and save the info
-	   in connmx */
-	connmx = calloc(sizeof(pcb_subnet_dist_t), vtp0_len(subnets) * vtp0_len(subnets));
-	for(s1 = 0; s1 < vtp0_len(subnets); s1++) {
-		for(s2 = s1+1; s2 < vtp0_len(subnets); s2++) {
-			connmx[s2 * vtp0_len(subnets) + s1] = connmx[s1 * vtp0_len(subnets) + s2] = pcb_subnet_dist(sctx->pcb, subnets->array[s1], subnets->array[s2], acc);
-		}
-	}
-
-	/* Start collecting subnets into one big snowball of newly connected
-	   subnets. done[subnet] is 1 if a subnet is already in the snowball.
-	   Use a greedy algorithm: mark the first subnet as dine, then always
-	   add the shortest from any 'undone' subnet to any 'done' */
-	done = calloc(vtp0_len(subnets)+1, 1);
-	done[0] = 1;
-	for(left = vtp0_len(subnets)-1; left > 0; left--) {
-		double best_dist = HUGE_VAL;
-		int bestu;
-		pcb_subnet_dist_t *best = NULL, *curr;
-
-		for(su = 1; su < vtp0_len(subnets); su++) {
-			if (done[su]) continue;
-			for(sd = 0; sd < vtp0_len(subnets); sd++) {
-				curr = &connmx[su * vtp0_len(subnets) + sd];
-				if ((done[sd]) && (curr->dist2 < best_dist)) {
-					bestu = su;
-					best_dist = curr->dist2;
-					best = curr;
-				}
-			}
-		}
+	/* Connect subnets into one big snowball using a minimal spanning tree of
+	   the shortest connections between subnets. Small nets measure every
+	   subnet pair; large nets (e.g. power nets with thousands of unconnected
+	   pads) look up nearby subnets only. */
+	ns = vtp0_len(subnets);
+	edges = malloc(sizeof(pcb_subnet_edge_t) * (ns+1));
+	if (ns <= PCB_SUBNET_SPATIAL_MIN)
+		nedges = pcb_subnet_mst_dense(sctx->pcb, subnets, acc, edges);
+	else
+		nedges = pcb_subnet_mst_spatial(sctx->pcb, subnets, acc, edges);
 
-		if (best == NULL) {
-			/* Unlikely: if there are enough restrictions on the search, e.g.
-			   PCB_RATACC_ONLY_MANHATTAN for the old autorouter is on and some
-			   subnets have only heavy terminals made of non-manhattan-lines,
-			   we will not find a connection. When best is NULL, that means
-			   no connection found between any undone subnet to any done subnet
-			   found, so some subnets will remain disconnected (there is no point
-			   in looping more, this won't improve) */
-			sctx->missing++;
-			rnd_message(RND_MSG_WARNING, "Netlist problem: could not find the best rat line, rat missing (#1)\n");
-			break;
-		}
+	for(en = 0; en < nedges; en++) {
+		pcb_subnet_dist_t *best = &edges[en].dist;
 
-		/* best connection is 'best' between from 'undone' network bestu; draw the rat */
+		/* draw the rat */
 		line = pcb_rat_new(sctx->pcb->Data, -1,
 			best->o1x, best->o1y, best->o2x, best->o2y, best->o1g, best->o2g,
 			conf_core.appearance.rat_thickness, pcb_no_flags(),
@@ -808,12 +811,20 @@ rnd_cardinal_t pcb_net_map_subnets(pcb_short_ctx_t *sctx, pcb_rat_accuracy_t acc
 			sctx->missing++;
 			rnd_message(RND_MSG_WARNING, "Netlist problem: could not find the best rat line, rat missing (#2)\n");
 		}
-		done[bestu] = 1;
+	}
+
+	if ((ns > 1) && (nedges < ns-1)) {
+		/* Unlikely: if there are enough restrictions on the search, e.g.
+		   PCB_RATACC_ONLY_MANHATTAN for the old autorouter is on and some
+		   subnets have only heavy terminals made of non-manhattan-lines,
+		   we will not find a connection. Some subnets will remain
+		   disconnected. */
+		sctx->missing++;
+		rnd_message(RND_MSG_WARNING, "Netlist problem: could not find the best rat line, rat missing (#1)\n");
 	}
 
 	/* cleanup */
-	free(connmx);
-	free(done);
+	free(edges);
 	pcb_find_free(&fctx);
 	return drawn;
 }
@@ -862,6 +873,7 @@ rnd_cardinal_t pcb_net_add_all_rats(const pcb_board_t *pcb, pcb_rat_accuracy_t a
 
 
 	pcb_net_short_ctx_init(&sctx, pcb, NULL);
+	pcb_find_cache_begin((pcb_board_t *)pcb); /* only rats are added while crawling nets */
 
 	for(e = htsp_first(&pcb->netlist[PCB_NETLIST_EDITED]); e != NULL; e = htsp_next(&pcb->netlist[PCB_NETLIST_EDITED], e)) {
 		pcb_net_t *net = e->value;
@@ -869,7 +881,7 @@ rnd_cardinal_t pcb_net_add_all_rats(const pcb_board_t *pcb, pcb_rat_accuracy_t a
 			pcb_net_term_t *t;
 			int has_selection = 0;
 			for(t = pcb_termlist_first(&net->conns); t != NULL; t = pcb_termlist_next(t)) {
-				pcb_any_obj_t *o = pcb_term_find_name(pcb, pcb->Data, PCB_LYT_COPPER, t->refdes, t->term, NULL, NULL);
+				pcb_any_obj_t *o = short_ctx_term_find(&sctx, t->refdes, t->term);
 				if ((o != NULL) && (PCB_FLAG_TEST(PCB_FLAG_SELECTED, o))) {
 					has_selection = 1;
 					break;
@@ -886,6 +898,8 @@ rnd_cardinal_t pcb_net_add_all_rats(const pcb_board_t *pcb, pcb_rat_accuracy_t a
 		pcb_net_reset_subnets(&subnets);
 	}
 
+	pcb_find_cache_end((pcb_board_t *)pcb);
+
 	if (acc & PCB_RATACC_INFO) {
 		long rem = ratlist_length(&pcb->Data->Rat);
 		if (rem > 0)
@@ -1121,7 +1135,7 @@ rnd_cardinal_t pcb_net_ripup(pcb_board_t *pcb, pcb_net_t *net)
 	fctx.only_mark_rats = 1; /* do not trust rats, but do mark them */
 
 	for(t = pcb_termlist_first(&net->conns), n = 0; t != NULL; t = pcb_termlist_next(t), n++)
-		pcb_net_term_crawl(pcb, t, &fctx, &first, NULL);
+		pcb_net_term_crawl(pcb, NULL, t, &fctx, &first, NULL);
 
 	pcb_undo_save_serial();
 	pcb_draw_inhibit_inc();
@@ -156,6 +156,12 @@ typedef struct {
 	htsp_t found;
 	rnd_cardinal_t changed, missing, num_shorts;
 	int cancel_advanced; /* do not do any time consuming advanced operations (such as mincut) in the event handler because the user already clicked cancel */
+
+	/* refdes -> (pcb_subc_t *) index for looking up netlist terminals; built
+	   on first use, assumes subcircuits are not changed during the lifetime
+	   of the context (adding rats is fine) */
+	htsp_t refdes;
+	unsigned refdes_inited:1;
 } pcb_short_ctx_t;
 
 void pcb_net_short_ctx_init(pcb_short_ctx_t *sctx, const pcb_board_t *pcb, pcb_net_t *net);
@@ -25,6 +25,8 @@
  */
 
 #include <assert.h>
+#include <math.h>
+#include <librnd/poly/rtree.h>
 #include "obj_pstk_inlines.h"
 
 typedef struct {
@@ -422,11 +424,298 @@ static pcb_subnet_dist_t pcb_subnet_dist(const pcb_board_t *pcb, vtp0_t *objs1,
 		}
 	}
 
-	best.o1g = get_obj_grp(pcb, best.o1);
-	best.o2g = get_obj_grp(pcb, best.o2);
+	if (best.o1 != NULL) {
+		best.o1g = get_obj_grp(pcb, best.o1);
+		best.o2g = get_obj_grp(pcb, best.o2);
+	}
 	return best;
 }
 
+/*** minimal spanning tree of subnets ***/
+
+/* Below this many subnets the dense algorithm is used: it computes the
+   distance of every subnet pair, which is cheap for small nets and yields
+   the very same rats the old greedy code did */
+#define PCB_SUBNET_SPATIAL_MIN 32
+
+typedef struct {
+	long s1, s2;            /* subnet indices of the two ends */
+	pcb_subnet_dist_t dist;
+} pcb_subnet_edge_t;
+
+/* Prim's algorithm on the full distance graph; O(S^2) distance calculations
+   but only O(S) memory. Tie breaking matches the old greedy code: lowest
+   index undone subnet first, then lowest index done subnet. Fills in edges[]
+   in the order rats should be drawn and returns the number of edges found. */
+static long pcb_subnet_mst_dense(const pcb_board_t *pcb, vtp0_t *subnets, pcb_rat_accuracy_t acc, pcb_subnet_edge_t *edges)
+{
+	long ns = vtp0_len(subnets), su, added, bestu, nedges = 0;
+	pcb_subnet_edge_t *key; /* key[su]: best known connection from undone subnet su to any done subnet */
+	char *done;
+
+	if (ns < 2)
+		return 0;
+
+	key = malloc(sizeof(pcb_subnet_edge_t) * ns);
+	done = calloc(ns, 1);
+	for(su = 0; su < ns; su++) {
+		key[su].s1 = su;
+		key[su].s2 = -1;
+		key[su].dist = sdist_invalid;
+	}
+
+	done[0] = 1;
+	for(added = 0; nedges < ns-1; added = bestu) {
+		double best_dist = HUGE_VAL;
+
+		/* only the connections to the subnet just added can improve the keys */
+		for(su = 1; su < ns; su++) {
+			pcb_subnet_dist_t curr;
+			if (done[su])
+				continue;
+			if (su < added)
+				curr = pcb_subnet_dist(pcb, subnets->array[su], subnets->array[added], acc);
+			else
+				curr = pcb_subnet_dist(pcb, subnets->array[added], subnets->array[su], acc);
+			if ((curr.dist2 < key[su].dist.dist2) || ((curr.dist2 == key[su].dist.dist2) && (curr.dist2 < HUGE_VAL) && (added < key[su].s2))) {
+				key[su].s2 = added;
+				key[su].dist = curr;
+			}
+		}
+
+		bestu = -1;
+		for(su = 1; su < ns; su++) {
+			if ((!done[su]) && (key[su].dist.dist2 < best_dist)) {
+				bestu = su;
+				best_dist = key[su].dist.dist2;
+			}
+		}
+
+		if (bestu < 0)
+			break; /* the remaining subnets can not be connected */
+
+		edges[nedges++] = key[bestu];
+		done[bestu] = 1;
+	}
+
+	free(key);
+	free(done);
+	return nedges;
+}
+
+typedef struct {
+	rnd_rtree_box_t box;
+	long sn;                /* index of the subnet the object is part of */
+} pcb_subnet_box_t;
+
+typedef struct {
+	const pcb_board_t *pcb;
+	vtp0_t *subnets;
+	pcb_rat_accuracy_t acc;
+	rnd_rtree_t tree;       /* of pcb_subnet_box_t: bbox of every object of every subnet */
+	rnd_rtree_box_t *sbox;  /* per subnet: bbox of all objects of the subnet */
+	rnd_rtree_box_t world;  /* bbox of all subnets */
+	long *parent;           /* union-find of subnets merged into components */
+	long *seen;             /* per subnet: last query stamp the subnet was evaluated in */
+	long stamp;
+} pcb_subnet_mst_t;
+
+static long subnet_uf_find(pcb_subnet_mst_t *ctx, long s)
+{
+	while(ctx->parent[s] != s) {
+		ctx->parent[s] = ctx->parent[ctx->parent[s]];
+		s = ctx->parent[s];
+	}
+	return s;
+}
+
+/* Returns 1 if d between subnets lo and hi is a better connection than best;
+   total ordering (distance, then subnet indices) is required so that equal
+   distances can not introduce a loop */
+static int subnet_edge_better(const pcb_subnet_dist_t *d, long lo, long hi, const pcb_subnet_edge_t *best)
+{
+	if (d->dist2 == HUGE_VAL)
+		return 0;
+	if (best->s2 < 0)
+		return 1;
+	if (d->dist2 != best->dist.dist2)
+		return d->dist2 < best->dist.dist2;
+	if (lo != best->s1)
+		return lo < best->s1;
+	return hi < best->s2;
+}
+
+#define SUBNET_CLAMP(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+
+/* Evaluate subnets of other components that have objects within radius r
+   of subnet s's bbox; update best if any of them is closer. Returns 1 if
+   the search box covered the whole world (no more subnets to find). */
+static int subnet_search(pcb_subnet_mst_t *ctx, long s, long comp, double r, pcb_subnet_edge_t *best)
+{
+	rnd_rtree_box_t sb;
+	rnd_rtree_it_t it;
+	pcb_subnet_box_t *b;
+	const rnd_rtree_box_t *o = &ctx->sbox[s];
+	double x1 = (double)o->x1 - r - 1, y1 = (double)o->y1 - r - 1, x2 = (double)o->x2 + r + 1, y2 = (double)o->y2 + r + 1;
+
+	/* clamping to the world in double avoids coord overflow on large r */
+	sb.x1 = SUBNET_CLAMP(x1, ctx->world.x1 - 1, ctx->world.x2 + 1);
+	sb.y1 = SUBNET_CLAMP(y1, ctx->world.y1 - 1, ctx->world.y2 + 1);
+	sb.x2 = SUBNET_CLAMP(x2, ctx->world.x1 - 1, ctx->world.x2 + 1);
+	sb.y2 = SUBNET_CLAMP(y2, ctx->world.y1 - 1, ctx->world.y2 + 1);
+
+	for(b = rnd_rtree_first(&it, &ctx->tree, &sb); b != NULL; b = rnd_rtree_next(&it)) {
+		long t = b->sn, lo, hi;
+		pcb_subnet_dist_t d;
+
+		if ((ctx->seen[t] == ctx->stamp) || (subnet_uf_find(ctx, t) == comp))
+			continue;
+		ctx->seen[t] = ctx->stamp;
+
+		if (s < t) { lo = s; hi = t; }
+		else { lo = t; hi = s; }
+		d = pcb_subnet_dist(ctx->pcb, ctx->subnets->array[lo], ctx->subnets->array[hi], ctx->acc);
+		if (subnet_edge_better(&d, lo, hi, best)) {
+			best->s1 = lo;
+			best->s2 = hi;
+			best->dist = d;
+		}
+	}
+
+	return (x1 <= ctx->world.x1) && (y1 <= ctx->world.y1) && (x2 >= ctx->world.x2) && (y2 >= ctx->world.y2);
+}
+
+/* Find the closest subnet of another component to subnet s and update
+   best (the best known connection of s's component) if it's closer. Rat
+   endpoints are always within the bbox of their objects, so a subnet that
+   has no object within r of s's bbox can not be closer than r. */
+static void subnet_nearest(pcb_subnet_mst_t *ctx, long s, long comp, double r0, pcb_subnet_edge_t *best)
+{
+	double r;
+
+	ctx->stamp++;
+
+	/* anything farther than the component's best known connection is useless */
+	if (best->s2 >= 0) {
+		subnet_search(ctx, s, comp, sqrt(best->dist.dist2), best);
+		return;
+	}
+
+	for(r = r0;; r *= 2) {
+		int all = subnet_search(ctx, s, comp, r, best);
+		if (best->s2 >= 0) {
+			/* found something, but a subnet outside of r may still be closer
+			   than that; already evaluated subnets are skipped */
+			if (sqrt(best->dist.dist2) > r)
+				subnet_search(ctx, s, comp, sqrt(best->dist.dist2), best);
+			return;
+		}
+		if (all)
+			return;
+	}
+}
+
+/* Boruvka's algorithm: in each round every component is connected to its
+   closest other component; closest subnets are looked up using an rtree
+   so only nearby subnet pairs are ever measured. There are at most
+   log2(S) rounds. Fills in edges[] and returns the number of edges found. */
+static long pcb_subnet_mst_spatial(const pcb_board_t *pcb, vtp0_t *subnets, pcb_rat_accuracy_t acc, pcb_subnet_edge_t *edges)
+{
+	pcb_subnet_mst_t ctx;
+	pcb_subnet_box_t *boxes, *b;
+	pcb_subnet_edge_t *cbest;
+	char *empty;
+	long ns = vtp0_len(subnets), nobj = 0, s, n, nedges = 0, merged;
+	double r0;
+
+	if (ns < 2)
+		return 0;
+
+	for(s = 0; s < ns; s++)
+		nobj += vtp0_len((vtp0_t *)subnets->array[s]);
+
+	ctx.pcb = pcb;
+	ctx.subnets = subnets;
+	ctx.acc = acc;
+	ctx.sbox = malloc(sizeof(rnd_rtree_box_t) * ns);
+	ctx.parent = malloc(sizeof(long) * ns);
+	ctx.seen = calloc(sizeof(long), ns);
+	ctx.stamp = 0;
+	cbest = malloc(sizeof(pcb_subnet_edge_t) * ns);
+	empty = calloc(ns, 1);
+	boxes = malloc(sizeof(pcb_subnet_box_t) * (nobj+1));
+
+	rnd_rtree_init(&ctx.tree);
+	ctx.world.x1 = ctx.world.y1 = RND_MAX_COORD;
+	ctx.world.x2 = ctx.world.y2 = -RND_MAX_COORD;
+	for(s = 0, b = boxes; s < ns; s++) {
+		vtp0_t *objs = subnets->array[s];
+		rnd_rtree_box_t *sb = &ctx.sbox[s];
+
+		ctx.parent[s] = s;
+		sb->x1 = sb->y1 = RND_MAX_COORD;
+		sb->x2 = sb->y2 = -RND_MAX_COORD;
+		empty[s] = 1;
+		for(n = 0; n < vtp0_len(objs); n++) {
+			pcb_any_obj_t *o = objs->array[n];
+			if (o->type == PCB_OBJ_RAT) /* can't be a rat endpoint */
+				continue;
+			b->box.x1 = o->BoundingBox.X1; b->box.y1 = o->BoundingBox.Y1;
+			b->box.x2 = o->BoundingBox.X2; b->box.y2 = o->BoundingBox.Y2;
+			b->sn = s;
+			rnd_rtree_insert(&ctx.tree, b, &b->box);
+			if (b->box.x1 < sb->x1) sb->x1 = b->box.x1;
+			if (b->box.y1 < sb->y1) sb->y1 = b->box.y1;
+			if (b->box.x2 > sb->x2) sb->x2 = b->box.x2;
+			if (b->box.y2 > sb->y2) sb->y2 = b->box.y2;
+			empty[s] = 0;
+			b++;
+		}
+		if (empty[s])
+			continue;
+		if (sb->x1 < ctx.world.x1) ctx.world.x1 = sb->x1;
+		if (sb->y1 < ctx.world.y1) ctx.world.y1 = sb->y1;
+		if (sb->x2 > ctx.world.x2) ctx.world.x2 = sb->x2;
+		if (sb->y2 > ctx.world.y2) ctx.world.y2 = sb->y2;
+	}
+
+	/* initial search radius: typical distance between evenly spread subnets */
+	r0 = (double)RND_MAX(ctx.world.x2 - ctx.world.x1, ctx.world.y2 - ctx.world.y1) / sqrt(ns) + 1;
+
+	do {
+		for(s = 0; s < ns; s++)
+			cbest[s].s2 = -1;
+
+		for(s = 0; s < ns; s++)
+			if (!empty[s])
+				subnet_nearest(&ctx, s, subnet_uf_find(&ctx, s), r0, &cbest[subnet_uf_find(&ctx, s)]);
+
+		/* cbest[] is indexed by component roots as of the start of the round */
+		merged = 0;
+		for(s = 0; s < ns; s++) {
+			long c1, c2;
+			if (cbest[s].s2 < 0)
+				continue;
+			c1 = subnet_uf_find(&ctx, cbest[s].s1);
+			c2 = subnet_uf_find(&ctx, cbest[s].s2);
+			if (c1 == c2) /* two components picked the same connection */
+				continue;
+			ctx.parent[c2] = c1;
+			edges[nedges++] = cbest[s];
+			merged++;
+		}
+	} while((merged > 0) && (nedges < ns-1));
+
+	rnd_rtree_uninit(&ctx.tree);
+	free(boxes);
+	free(empty);
+	free(cbest);
+	free(ctx.seen);
+	free(ctx.parent);
+	free(ctx.sbox);
+	return nedges;
+}
+
 void pcb_netlist_geo_init(void)
 {
 	sdist_invalid.dist2 = HUGE_VAL; /* on some systems this is not constant and can be used as an initializer */
@@ -178,6 +178,8 @@ void pcb_poly_free_fields(pcb_poly_t * polygon)
 
 	if (polygon->Clipped)
 		rnd_polyarea_free(&polygon->Clipped);
+	if (polygon->clip_src)
+		rnd_polyarea_free(&polygon->clip_src);
 	rnd_poly_contours_free(&polygon->NoHoles);
 
 	/* have to preserve parent info for unreg */
@@ -43,6 +43,7 @@ struct pcb_poly_s  {               /* holds information about a polygon */
 	rnd_cardinal_t PointN;           /* number of points in polygon */
 	rnd_cardinal_t PointMax;         /* max number from malloc() */
 	rnd_polyarea_t *Clipped;         /* the clipped region of this polygon */
+	rnd_polyarea_t *clip_src;        /* cache: the unclipped polygon as of the last clip; NULL if unknown */
 	rnd_pline_t *NoHoles;            /* the polygon broken into hole-less regions */
 	int NoHolesValid;                /* Is the NoHoles polygon up to date? */
 	rnd_point_t *Points;             /* data */
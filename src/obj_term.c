@@ -273,7 +273,6 @@ pcb_term_err_t pcb_term_undoable_rename(pcb_board_t *pcb, pcb_any_obj_t *obj, co
 #define CHECK_TERM_LY(ob) \
 	do { \
 		if (RND_NSTRCMP(term_name, ob->term) == 0) { \
-			if (parent_out != NULL) *parent_out = subc; \
 			if (gid_out != NULL) *gid_out = pcb_layer_get_group_(layer); \
 			return (pcb_any_obj_t *)ob; \
 		} \
@@ -282,7 +281,6 @@ pcb_term_err_t pcb_term_undoable_rename(pcb_board_t *pcb, pcb_any_obj_t *obj, co
 #define CHECK_TERM_GL(ob) \
 	do { \
 		if (RND_NSTRCMP(term_name, ob->term) == 0) { \
-			if (parent_out != NULL) *parent_out = subc; \
 			if (gid_out != NULL) { \
 				*gid_out = -1; \
 				pcb_layergrp_list(pcb, lyt, gid_out, 1); \
@@ -291,18 +289,14 @@ pcb_term_err_t pcb_term_undoable_rename(pcb_board_t *pcb, pcb_any_obj_t *obj, co
 		} \
 	} while(0)
 
-pcb_any_obj_t *pcb_term_find_name(const pcb_board_t *pcb, pcb_data_t *data, pcb_layer_type_t lyt, const char *subc_name, const char *term_name, pcb_subc_t **parent_out, rnd_layergrp_id_t *gid_out)
+pcb_any_obj_t *pcb_term_find_name_subc(const pcb_board_t *pcb, pcb_subc_t *subc, pcb_layer_type_t lyt, const char *term_name, rnd_layergrp_id_t *gid_out)
 {
-	pcb_subc_t *subc;
 	pcb_layer_t *layer;
 	int l;
 
 	if (lyt == 0)
 		return NULL;
 
-	if ((subc = pcb_subc_by_refdes(data, subc_name)) == NULL)
-		return NULL;
-
 	if (PCB_FLAG_TEST(PCB_FLAG_NONETLIST, subc))
 		return NULL;
 
@@ -339,6 +333,23 @@ pcb_any_obj_t *pcb_term_find_name(const pcb_board_t *pcb, pcb_data_t *data, pcb_
 	return NULL;
 }
 
+pcb_any_obj_t *pcb_term_find_name(const pcb_board_t *pcb, pcb_data_t *data, pcb_layer_type_t lyt, const char *subc_name, const char *term_name, pcb_subc_t **parent_out, rnd_layergrp_id_t *gid_out)
+{
+	pcb_subc_t *subc;
+	pcb_any_obj_t *o;
+
+	if (lyt == 0)
+		return NULL;
+
+	if ((subc = pcb_subc_by_refdes(data, subc_name)) == NULL)
+		return NULL;
+
+	o = pcb_term_find_name_subc(pcb, subc, lyt, term_name, gid_out);
+	if ((o != NULL) && (parent_out != NULL))
+		*parent_out = subc;
+	return o;
+}
+
 #undef CHECK_TERM_LY
 #undef CHECK_TERM_GL
 
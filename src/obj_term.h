@@ -89,4 +89,7 @@ pcb_term_err_t pcb_term_undoable_rename(pcb_board_t *pcb, pcb_any_obj_t *obj, co
    Ignores subcircuits marked as nonetlist even if explicitly named. */
 pcb_any_obj_t *pcb_term_find_name(const pcb_board_t *pcb, pcb_data_t *data, pcb_layer_type_t lyt, const char *subc_name, const char *term_name, pcb_subc_t **parent_out, rnd_layergrp_id_t *gid_out);
 
+/* Same as pcb_term_find_name() but within an already known subcircuit */
+pcb_any_obj_t *pcb_term_find_name_subc(const pcb_board_t *pcb, pcb_subc_t *subc, pcb_layer_type_t lyt, const char *term_name, rnd_layergrp_id_t *gid_out);
+
 #endif
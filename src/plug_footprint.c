@@ -238,6 +238,8 @@ pcb_fplibrary_t *fp_lib_search_len(pcb_fplibrary_t *dir, const char *name, int n
 	if (dir->type != PCB_LIB_DIR)
 		return NULL;
 
+	pcb_fp_lib_expand(dir);
+
 	for(n = 0; n < dir->data.dir.children.used; n++) {
 		pcb_fplibrary_t *l = dir->data.dir.children.array[n];
 		if (strncmp(l->name, name, name_len) == 0)
@@ -254,6 +256,8 @@ pcb_fplibrary_t *pcb_fp_lib_search(pcb_fplibrary_t *dir, const char *name)
 	if (dir->type != PCB_LIB_DIR)
 		return NULL;
 
+	pcb_fp_lib_expand(dir);
+
 	for(n = 0; n < dir->data.dir.children.used; n++) {
 	pcb_fplibrary_t *l = dir->data.dir.children.array[n];
 		if (strcmp(l->name, name) == 0)
@@ -274,6 +278,7 @@ pcb_fplibrary_t *pcb_fp_mkdir_len(pcb_fplibrary_t *parent, const char *name, int
 		l->name = rnd_strdup(name);
 	l->type = PCB_LIB_DIR;
 	l->data.dir.backend = NULL;
+	l->data.dir.lazy = NULL;
 	vtp0_init(&l->data.dir.children);
 	return l;
 }
@@ -357,12 +362,62 @@ void pcb_fp_sort_lib(void)
 		pcb_fp_sort_children(v->array[n]);
 }
 
+int pcb_fp_lib_expand(pcb_fplibrary_t *dir)
+{
+	pcb_fplibrary_t *root;
+	pcb_plug_fp_t *be;
+	char *loc;
+	int res;
+
+	if ((dir->type != PCB_LIB_DIR) || (dir->data.dir.lazy == NULL))
+		return 0;
+
+	/* only roots remember their backend */
+	for(root = dir; (root != NULL) && (root->data.dir.backend == NULL); root = root->parent) ;
+	be = (root == NULL) ? NULL : root->data.dir.backend;
+
+	/* clear first so that the backend can search and append in dir */
+	loc = dir->data.dir.lazy;
+	dir->data.dir.lazy = NULL;
+
+	if ((be == NULL) || (be->load_subdir == NULL))
+		res = -1;
+	else
+		res = be->load_subdir(be, dir, loc);
+	free(loc);
+
+	if (res < 0)
+		return -1;
+
+	pcb_fp_sort_children(dir);
+	return 0;
+}
+
+long pcb_fp_lib_expand_all(pcb_fplibrary_t *dir)
+{
+	long n, cnt = 0;
+
+	if (dir->type != PCB_LIB_DIR)
+		return 0;
+
+	if (dir->data.dir.lazy != NULL) {
+		pcb_fp_lib_expand(dir);
+		cnt++;
+	}
+
+	for(n = 0; n < dir->data.dir.children.used; n++)
+		cnt += pcb_fp_lib_expand_all(dir->data.dir.children.array[n]);
+
+	return cnt;
+}
+
 void fp_free_entry(pcb_fplibrary_t *l)
 {
 	switch(l->type) {
 		case PCB_LIB_DIR:
 			pcb_fp_free_children(l);
 			vtp0_uninit(&(l->data.dir.children));
+			free(l->data.dir.lazy);
 			break;
 		case PCB_LIB_FOOTPRINT:
 			if (l->data.fp.loc_info != NULL)
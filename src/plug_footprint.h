@@ -33,6 +33,7 @@ struct pcb_fplibrary_s {
 		struct { /* type == LIB_DIR */
 			vtp0_t children; /* of (pcb_fplibrary_t *) */
 			void *backend; /* pcb_plug_fp_t* */
+			char *lazy; /* if not NULL, children are not loaded yet; backend specific location of the dir, passed to load_subdir() of the root's backend by pcb_fp_lib_expand() */
 		} dir;
 		struct { /* type == LIB_FOOTPRINT */
 			char *loc_info;
@@ -96,6 +97,11 @@ struct pcb_plug_fp_s {
 	   expensive part of the load (e.g. wget) */
 	int (*load_dir)(pcb_plug_fp_t *ctx, const char *path, int force);
 
+/* Optional: load the children of dir, a directory load_dir() left unloaded
+   (with data.dir.lazy set); loc is the value of data.dir.lazy. Returns the
+   number of entries loaded or -1 on error. */
+	int (*load_subdir)(pcb_plug_fp_t *ctx, pcb_fplibrary_t *dir, const char *loc);
+
 /* Open a footprint for reading; if the footprint is parametric, it's run
    prefixed with libshell (or executed directly, if libshell is NULL).
    If name is not an absolute path, search_path is searched for the first match.
@@ -122,8 +128,16 @@ void pcb_fp_sort_lib(void);
 void pcb_fp_rmdir(pcb_fplibrary_t *dir);
 pcb_fplibrary_t *pcb_fp_mkdir_p(const char *path);
 pcb_fplibrary_t *pcb_fp_mkdir_len(pcb_fplibrary_t *parent, const char *name, int name_len);
+
+/* Search dir for a direct child called name; loads dir first if it is lazy */
 pcb_fplibrary_t *pcb_fp_lib_search(pcb_fplibrary_t *dir, const char *name);
 
+/* Load the children of a lazy dir (no-op for anything else); returns 0 on
+   success. The _all version does the same recursively for the whole subtree
+   and returns the number of dirs loaded. */
+int pcb_fp_lib_expand(pcb_fplibrary_t *dir);
+long pcb_fp_lib_expand_all(pcb_fplibrary_t *dir);
+
 /* Append a menu entry in the tree; fmt is optional (may be NULL) */
 pcb_fplibrary_t *pcb_fp_append_entry(pcb_fplibrary_t *parent, const char *name, pcb_fptype_t type, void *tags[], rnd_bool dup_tags, const char *fmt);
 
@@ -973,6 +973,23 @@ void pcb_disable_emergency_save(void)
 
 static rnd_hidval_t backup_timer;
 
+/* board and edit serial of the last backup, with the file name and format
+   it was written in */
+static struct {
+	long pcb_id;
+	unsigned long edit_serial;
+	char *fn, *fmt;
+} last_backup;
+
+static void backup_uninit(void)
+{
+	free(last_backup.fn);
+	free(last_backup.fmt);
+	last_backup.fn = last_backup.fmt = NULL;
+}
+
+static void pcb_backup_(int only_changed);
+
 /*
  * If the backup interval is > 0 then set another timer.  Otherwise
  * we do nothing and it is up to the GUI to call pcb_enable_autosave()
@@ -981,7 +998,7 @@ static rnd_hidval_t backup_timer;
 static void backup_cb(rnd_hidval_t data)
 {
 	backup_timer.ptr = NULL;
-	pcb_backup();
+	pcb_backup_(1);
 	if (conf_core.rc.backup_interval > 0 && rnd_gui->add_timer)
 		backup_timer = rnd_gui->add_timer(rnd_gui, backup_cb, 1000 * conf_core.rc.backup_interval, data);
 }
@@ -1004,11 +1021,12 @@ void pcb_enable_autosave(void)
 
 /* Saves the board in a backup file using the name configured in
    conf_core.rc.backup_name */
-void pcb_backup(void)
+static void pcb_backup_(int only_changed)
 {
 	char *filename = NULL;
 	const char *fmt = NULL;
 	pcb_plug_io_t *orig;
+	int res;
 
 	filename = rnd_build_fn(&PCB->hidlib, conf_core.rc.backup_name);
 	if (filename == NULL) {
@@ -1019,11 +1037,33 @@ void pcb_backup(void)
 	if ((conf_core.rc.backup_format != NULL) && (strcmp(conf_core.rc.backup_format, "original") != 0))
 		fmt = conf_core.rc.backup_format;
 
+	/* building and writing a large board blocks the UI; don't do that again
+	   if the backup file already holds this version of the board */
+	if (only_changed && (last_backup.fn != NULL) && (last_backup.pcb_id == PCB->ID) && (last_backup.edit_serial == PCB->edit_serial)
+		&& (strcmp(last_backup.fn, filename) == 0) && (strcmp(last_backup.fmt, (fmt == NULL ? "" : fmt)) == 0)
+		&& rnd_file_readable(NULL, filename)) {
+		free(filename);
+		return;
+	}
+
 	orig = PCB->Data->loader;
-	pcb_write_pcb_file(filename, rnd_true, fmt, rnd_true, rnd_false, -1, 0);
+	res = pcb_write_pcb_file(filename, rnd_true, fmt, rnd_true, rnd_false, -1, 0);
 	PCB->Data->loader = orig;
 
-	free(filename);
+	backup_uninit();
+	if (res != 0) {
+		free(filename);
+		return;
+	}
+	last_backup.fn = filename;
+	last_backup.fmt = rnd_strdup(fmt == NULL ? "" : fmt);
+	last_backup.pcb_id = PCB->ID;
+	last_backup.edit_serial = PCB->edit_serial;
+}
+
+void pcb_backup(void)
+{
+	pcb_backup_(0);
 }
 
 int pcb_write_pcb_file(const char *Filename, rnd_bool thePcb, const char *fmt, rnd_bool emergency, rnd_bool subc_only, long subc_idx, int askovr)
@@ -1254,4 +1294,5 @@ void pcb_io_uninit(void)
 	}
 	free(last_design_dir);
 	last_design_dir = NULL;
+	backup_uninit();
 }
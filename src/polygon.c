@@ -64,6 +64,9 @@ extern rnd_cardinal_t rnd_polyarea_split_selfisc(rnd_polyarea_t **pa);
 #define SUBTRACT_PIN_VIA_BATCH_SIZE 100
 #define SUBTRACT_PADSTACK_BATCH_SIZE 50
 #define SUBTRACT_LINE_BATCH_SIZE 20
+#define SUBTRACT_ARC_BATCH_SIZE 20
+#define SUBTRACT_TEXT_BATCH_SIZE 10
+#define CLIP_BATCH_LEVELS 32
 
 #define sqr(x) ((x)*(x))
 
@@ -478,33 +481,44 @@ static void poly_sub_text_cb(void *ctx_, pcb_any_obj_t *obj)
 static pcb_draw_info_t tsub_info;
 static rnd_xform_t tsub_xform;
 
-static int SubtractText(pcb_text_t * text, pcb_poly_t * p)
+/* return the clearance polygon for a text cutting into p */
+static rnd_polyarea_t *text_clearance_poly(pcb_text_t *text, pcb_poly_t *p)
 {
 	poly_poly_text_t sctx;
 	int by_bbox = !text->tight_clearance;
 
-	if (!PCB_FLAG_TEST(PCB_FLAG_CLEARLINE, text))
-		return 0;
-
 	if (by_bbox) {
 		/* old method: clear by bounding box */
 		const rnd_box_t *b = &text->BoundingBox;
 		rnd_coord_t clr = RND_MAX(conf_core.design.bloat, p->enforce_clearance);
-		rnd_polyarea_t *np;
-		if (!(np = rnd_poly_from_round_rect(b->X1 + conf_core.design.bloat, b->X2 - conf_core.design.bloat, b->Y1 + conf_core.design.bloat, b->Y2 - conf_core.design.bloat, clr)))
-			return -1;
-		return Subtract(np, p, rnd_true);
+		return rnd_poly_from_round_rect(b->X1 + conf_core.design.bloat, b->X2 - conf_core.design.bloat, b->Y1 + conf_core.design.bloat, b->Y2 - conf_core.design.bloat, clr);
 	}
 
-	/* new method: detailed clearance */
+	/* new method: detailed clearance; strokes are united so the polygon is
+	   cut only once per text */
 	sctx.poly = p;
+	sctx.pa = NULL;
 	sctx.clearance = text->clearance == 0 ? RND_MM_TO_COORD(0.175) : text->clearance;
-	sctx.sub = 1;
+	sctx.sub = 0;
 	sctx.thickness = text->thickness;
 	sctx.min_thick = pcb_text_min_thickness(pcb_layer_get_real(text->parent.layer));
 	tsub_info.xform = &tsub_xform;
 	pcb_text_decompose_text(&tsub_info, text, poly_sub_text_cb, &sctx);
-	return 1;
+	return sctx.pa;
+}
+
+static int SubtractText(pcb_text_t * text, pcb_poly_t * p)
+{
+	rnd_polyarea_t *np;
+
+	if (!PCB_FLAG_TEST(PCB_FLAG_CLEARLINE, text))
+		return 0;
+
+	np = text_clearance_poly(text, p);
+	if (np == NULL)
+		return text->tight_clearance ? 1 : -1; /* a text without strokes has nothing to clear */
+
+	return Subtract(np, p, rnd_true);
 }
 
 rnd_polyarea_t *pcb_poly_construct_text_clearance(pcb_text_t *text)
@@ -544,18 +558,155 @@ struct cpInfo {
 	rnd_bool solder;
 	rnd_polyarea_t *accumulate;
 	int batch_size;
+	unsigned cut_once:1;                     /* batches are collected in level[] and cut from the polygon only once */
+	rnd_polyarea_t *level[CLIP_BATCH_LEVELS]; /* level[n] is NULL or the union of 2^n batches */
+	int tiles;                               /* tiled full clip: number of tiles per axis; 0 when not tiled */
+	rnd_polyarea_t **tile;                   /* tiled full clip: tiles*tiles unions of clearances, row major */
+	rnd_coord_t tx, ty, tw, th;              /* tiled full clip: grid origin and tile size */
 	jmp_buf env;
 };
 
+/* Tiled full clip (design/poly_clip_tiles): each clearance shape is united
+   into the tile its center falls in, so unions stay local and small; tiles
+   are merged only at the end */
+static void clip_tile_add(struct cpInfo *info, rnd_polyarea_t *np)
+{
+	rnd_pline_t *pl = np->contours;
+	rnd_polyarea_t **t, *merged;
+	long tx, ty;
+
+	tx = (pl->xmin/2 + pl->xmax/2 - info->tx) / info->tw;
+	ty = (pl->ymin/2 + pl->ymax/2 - info->ty) / info->th;
+	if (tx < 0) tx = 0;
+	if (ty < 0) ty = 0;
+	if (tx >= info->tiles) tx = info->tiles - 1;
+	if (ty >= info->tiles) ty = info->tiles - 1;
+
+	t = &info->tile[ty * info->tiles + tx];
+	if (*t != NULL) {
+		rnd_polyarea_boolean_free(*t, np, &merged, RND_PBO_UNITE);
+		*t = merged;
+	}
+	else
+		*t = np;
+}
+
+static int pcb_poly_clip_tiles = -1; /* override of design/poly_clip_tiles when >= 0 */
+
+int pcb_poly_clip_tiles_override(int tiles)
+{
+	int old = pcb_poly_clip_tiles;
+	pcb_poly_clip_tiles = tiles;
+	return old;
+}
+
+static void clip_tile_init(struct cpInfo *info, const rnd_box_t *region)
+{
+	info->tiles = (pcb_poly_clip_tiles >= 0) ? pcb_poly_clip_tiles : conf_core.design.poly_clip_tiles;
+	if (info->tiles <= 0) {
+		info->tiles = 0;
+		info->tile = NULL;
+		return;
+	}
+	if (info->tiles > 256)
+		info->tiles = 256;
+
+	info->tile = calloc(sizeof(rnd_polyarea_t *), info->tiles * info->tiles);
+	info->tx = region->X1;
+	info->ty = region->Y1;
+	info->tw = (region->X2 - region->X1) / info->tiles + 1;
+	info->th = (region->Y2 - region->Y1) / info->tiles + 1;
+}
+
+/* Instead of cutting each batch from the polygon, which gets more complex
+   with every hole, batches are united pairwise in a binary counter, so each
+   boolean operation works on two shapes of similar size. The polygon is cut
+   only once, by clip_batch_subtract(); this matters for a full clip with
+   many clearances as well as for a local re-clip while dragging, where each
+   cut would be an operation on the whole pour. */
+static void clip_batch_push(struct cpInfo *info, rnd_polyarea_t *pa)
+{
+	rnd_polyarea_t *merged;
+	int n;
+
+	for(n = 0; (n < CLIP_BATCH_LEVELS-1) && (info->level[n] != NULL); n++) {
+		rnd_polyarea_boolean_free(info->level[n], pa, &merged, RND_PBO_UNITE);
+		info->level[n] = NULL;
+		pa = merged;
+	}
+
+	if (info->level[n] != NULL) { /* top level is full; unlikely, but can't overflow */
+		rnd_polyarea_boolean_free(info->level[n], pa, &merged, RND_PBO_UNITE);
+		pa = merged;
+	}
+	info->level[n] = pa;
+}
+
+static void clip_batch_subtract(struct cpInfo *info, pcb_poly_t *polygon)
+{
+	rnd_polyarea_t *pa = NULL, *merged;
+	int n;
+
+	if (info->tile != NULL) {
+		/* neighbouring tiles are merged first, in the binary counter */
+		for(n = 0; n < info->tiles * info->tiles; n++)
+			if (info->tile[n] != NULL)
+				clip_batch_push(info, info->tile[n]);
+		free(info->tile);
+		info->tile = NULL;
+	}
+
+	for(n = 0; n < CLIP_BATCH_LEVELS; n++) {
+		if (info->level[n] == NULL)
+			continue;
+		if (pa != NULL) {
+			rnd_polyarea_boolean_free(pa, info->level[n], &merged, RND_PBO_UNITE);
+			pa = merged;
+		}
+		else
+			pa = info->level[n];
+		info->level[n] = NULL;
+	}
+
+	if (pa != NULL)
+		Subtract(pa, polygon, rnd_true);
+}
+
 static void subtract_accumulated(struct cpInfo *info, pcb_poly_t *polygon)
 {
 	if (info->accumulate == NULL)
 		return;
-	Subtract(info->accumulate, polygon, rnd_true);
+	if (info->cut_once)
+		clip_batch_push(info, info->accumulate);
+	else
+		Subtract(info->accumulate, polygon, rnd_true);
 	info->accumulate = NULL;
 	info->batch_size = 0;
 }
 
+/* add the clearance shape np of an object to the current batch */
+static void clip_accumulate(struct cpInfo *info, pcb_poly_t *polygon, rnd_polyarea_t *np, int batch_max)
+{
+	rnd_polyarea_t *merged;
+
+	if (info->tile != NULL) {
+		clip_tile_add(info, np);
+		return;
+	}
+
+	if (info->accumulate == NULL)
+		merged = np;
+	else
+		rnd_polyarea_boolean_free(info->accumulate, np, &merged, RND_PBO_UNITE);
+
+	info->accumulate = merged;
+	info->batch_size++;
+	assert(info->accumulate != NULL);
+
+	if (info->batch_size == batch_max)
+		subtract_accumulated(info, polygon);
+}
+
 static int pcb_poly_clip_noop = 0;
 static void *pcb_poly_clip_prog_ctx;
 static void (*pcb_poly_clip_prog)(void *ctx) = NULL;
@@ -575,7 +726,6 @@ static rnd_rtree_dir_t padstack_sub_callback(void *cl, void *obj, const rnd_rtre
 	struct cpInfo *info = (struct cpInfo *)cl;
 	pcb_poly_t *polygon;
 	rnd_polyarea_t *np;
-	rnd_polyarea_t *merged;
 	rnd_layer_id_t i;
 
 	/* don't subtract the object that was put back! */
@@ -593,19 +743,9 @@ static rnd_rtree_dir_t padstack_sub_callback(void *cl, void *obj, const rnd_rtre
 	if (np == 0)
 		return rnd_RTREE_DIR_FOUND_CONT;
 
-	info->batch_size++;
 	POLY_CLIP_PROG();
 
-	if (info->accumulate == NULL)
-		merged = np;
-	else
-		rnd_polyarea_boolean_free(info->accumulate, np, &merged, RND_PBO_UNITE);
-
-	info->accumulate = merged;
-
-	if (info->batch_size == SUBTRACT_PADSTACK_BATCH_SIZE)
-		subtract_accumulated(info, polygon);
-
+	clip_accumulate(info, polygon, np, SUBTRACT_PADSTACK_BATCH_SIZE);
 	return rnd_RTREE_DIR_FOUND_CONT;
 }
 
@@ -614,6 +754,7 @@ static rnd_rtree_dir_t arc_sub_callback(void *cl, void *obj, const rnd_rtree_box
 	pcb_arc_t *arc = (pcb_arc_t *)obj;
 	struct cpInfo *info = (struct cpInfo *) cl;
 	pcb_poly_t *polygon;
+	rnd_polyarea_t *np;
 
 	/* don't subtract the object that was put back! */
 	if (obj == info->other)
@@ -625,8 +766,11 @@ static rnd_rtree_dir_t arc_sub_callback(void *cl, void *obj, const rnd_rtree_box
 
 	polygon = info->polygon;
 
-	if (SubtractArc(arc, polygon) < 0)
+	np = pcb_poly_from_pcb_arc(arc, arc->Thickness + pcb_obj_clearance_p2(arc, polygon));
+	if (np == NULL)
 		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+
+	clip_accumulate(info, polygon, np, SUBTRACT_ARC_BATCH_SIZE);
 	return rnd_RTREE_DIR_FOUND_CONT;
 }
 
@@ -838,7 +982,6 @@ static rnd_rtree_dir_t line_sub_callback(void *cl, void *obj, const rnd_rtree_bo
 	struct cpInfo *info = (struct cpInfo *) cl;
 	pcb_poly_t *polygon;
 	rnd_polyarea_t *np;
-	rnd_polyarea_t *merged;
 
 	/* don't subtract the object that was put back! */
 	if (obj == info->other)
@@ -853,18 +996,7 @@ static rnd_rtree_dir_t line_sub_callback(void *cl, void *obj, const rnd_rtree_bo
 	if (!np)
 		return rnd_RTREE_DIR_NOT_FOUND_CONT;
 
-	if (info->accumulate == NULL)
-		merged = np;
-	else
-		rnd_polyarea_boolean_free(info->accumulate, np, &merged, RND_PBO_UNITE);
-
-	info->accumulate = merged;
-	info->batch_size++;
-	assert(info->accumulate != NULL);
-
-	if (info->batch_size == SUBTRACT_LINE_BATCH_SIZE)
-		subtract_accumulated(info, polygon);
-
+	clip_accumulate(info, polygon, np, SUBTRACT_LINE_BATCH_SIZE);
 	return rnd_RTREE_DIR_FOUND_CONT;
 }
 
@@ -873,6 +1005,7 @@ static rnd_rtree_dir_t text_sub_callback(void *cl, void *obj, const rnd_rtree_bo
 	pcb_text_t *text = (pcb_text_t *)obj;
 	struct cpInfo *info = (struct cpInfo *) cl;
 	pcb_poly_t *polygon;
+	rnd_polyarea_t *np;
 
 	/* don't subtract the object that was put back! */
 	if (obj == info->other)
@@ -883,8 +1016,11 @@ static rnd_rtree_dir_t text_sub_callback(void *cl, void *obj, const rnd_rtree_bo
 	POLY_CLIP_PROG();
 
 	polygon = info->polygon;
-	if (SubtractText(text, polygon) < 0)
-		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+	np = text_clearance_poly(text, polygon);
+	if (np == NULL)
+		return text->tight_clearance ? rnd_RTREE_DIR_FOUND_CONT : rnd_RTREE_DIR_NOT_FOUND_CONT;
+
+	clip_accumulate(info, polygon, np, SUBTRACT_TEXT_BATCH_SIZE);
 	return rnd_RTREE_DIR_FOUND_CONT;
 }
 
@@ -943,6 +1079,12 @@ static rnd_cardinal_t clearPoly(pcb_data_t *Data, pcb_layer_t *Layer, pcb_poly_t
 		r = 0;
 		info.accumulate = NULL;
 		info.batch_size = 0;
+		info.cut_once = !noop;
+		memset(info.level, 0, sizeof(info.level));
+		if ((here == NULL) && !noop)
+			clip_tile_init(&info, &region);
+		else
+			info.tile = NULL;
 
 		rnd_rtree_search_any(Data->padstack_tree, (rnd_rtree_box_t *)&region, NULL, padstack_sub_callback, &info, &seen);
 #ifndef PCB_WANT_POLYBOOL2
@@ -964,6 +1106,7 @@ static rnd_cardinal_t clearPoly(pcb_data_t *Data, pcb_layer_t *Layer, pcb_poly_t
 		}
 		PCB_END_LOOP;
 		subtract_accumulated(&info, polygon);
+		clip_batch_subtract(&info, polygon);
 	}
 	if (!noop)
 		polygon->NoHolesValid = 0;
@@ -980,9 +1123,16 @@ static int Unsubtract(rnd_polyarea_t * np1, pcb_poly_t * p)
 	assert(np);
 	assert(p); /* NOTE: p->clipped might be NULL if a poly is "cleared out of existence" and is now coming back */
 
-	orig_poly = pcb_poly_to_polyarea(p, &need_full);
-
-	x = rnd_polyarea_boolean_free(np, orig_poly, &clipped_np, RND_PBO_ISECT);
+	if ((p->clip_src != NULL) && !p->clip_dirty) {
+		/* the unclipped outline is cached since the last clip; converting it
+		   again is the expensive part on a big pour */
+		x = rnd_polyarea_boolean(np, p->clip_src, &clipped_np, RND_PBO_ISECT);
+		rnd_polyarea_free(&np);
+	}
+	else {
+		orig_poly = pcb_poly_to_polyarea(p, &need_full);
+		x = rnd_polyarea_boolean_free(np, orig_poly, &clipped_np, RND_PBO_ISECT);
+	}
 	if (x != rnd_err_ok) {
 		fprintf(stderr, "Error while clipping RND_PBO_ISECT: %d\n", x);
 		rnd_polyarea_free(&clipped_np);
@@ -1093,6 +1243,8 @@ int pcb_poly_init_clip_prog(pcb_data_t *Data, pcb_layer_t *layer, pcb_poly_t *p,
 
 	if ((!force) && (Data->clip_inhibit > 0)) {
 		p->clip_dirty = 1;
+		if (p->clip_src)
+			rnd_polyarea_free(&p->clip_src);
 		return 0;
 	}
 
@@ -1108,6 +1260,11 @@ int pcb_poly_init_clip_prog(pcb_data_t *Data, pcb_layer_t *layer, pcb_poly_t *p,
 	}
 	rnd_poly_contours_free(&p->NoHoles);
 
+	if (p->clip_src)
+		rnd_polyarea_free(&p->clip_src);
+	if (p->Clipped != NULL)
+		rnd_polyarea_copy0(&p->clip_src, p->Clipped);
+
 	p->clip_dirty = 0;
 
 	if (layer == NULL)
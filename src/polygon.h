@@ -85,6 +85,10 @@ int pcb_poly_init_clip_prog(pcb_data_t *Data, pcb_layer_t *layer, pcb_poly_t *p,
    pcb_poly_init_clip() on the given polygon */
 rnd_cardinal_t pcb_poly_num_clears(pcb_data_t *data, pcb_layer_t *layer, pcb_poly_t *polygon);
 
+/* Use tiles*tiles tiles for full clips instead of design/poly_clip_tiles;
+   -1 restores the conf setting. Returns the previous override. */
+int pcb_poly_clip_tiles_override(int tiles);
+
 
 rnd_bool pcb_poly_is_point_in_p(rnd_coord_t, rnd_coord_t, rnd_coord_t, pcb_poly_t *);
 rnd_bool pcb_poly_is_point_in_p_ignore_holes(rnd_coord_t, rnd_coord_t, pcb_poly_t *);
@@ -62,6 +62,7 @@
 #include "undo_old.h"
 #include "flag_str.h"
 #include "conf_core.h"
+#include "find.h"
 #include <librnd/core/compat_misc.h>
 
 #include "obj_poly_draw.h"
@@ -121,6 +122,9 @@ int pcb_undo(rnd_bool draw)
 	else if (pcb_undo_and_draw)
 		pcb_draw();
 
+	/* callers do not always set the changed flag after an undo/redo */
+	PCB->edit_serial++;
+	pcb_find_island_flush();
 	rnd_event(&PCB->hidlib, PCB_EVENT_UNDO_POST, "i", PCB_UNDO_EV_UNDO);
 
 	return res;
@@ -128,6 +132,8 @@ int pcb_undo(rnd_bool draw)
 
 int pcb_undo_above(uundo_serial_t s_min)
 {
+	PCB->edit_serial++;
+	pcb_find_island_flush();
 	return uundo_undo_above(&pcb_uundo, s_min);
 }
 
@@ -170,6 +176,9 @@ int pcb_redo(rnd_bool draw)
 	else if (pcb_undo_and_draw)
 		pcb_draw();
 
+	/* callers do not always set the changed flag after an undo/redo */
+	PCB->edit_serial++;
+	pcb_find_island_flush();
 	rnd_event(&PCB->hidlib, PCB_EVENT_UNDO_POST, "i", PCB_UNDO_EV_REDO);
 
 	return res;
@@ -180,6 +189,7 @@ int pcb_redo(rnd_bool draw)
  */
 void pcb_undo_restore_serial(void)
 {
+	pcb_find_island_flush();
 	if (added_undo_between_increment_and_restore)
 		rnd_message(RND_MSG_ERROR, "ERROR: Operations were added to the Undo stack with an incorrect serial number\n");
 	between_increment_and_restore = rnd_false;
@@ -205,6 +215,7 @@ void pcb_undo_save_serial(void)
  */
 void pcb_undo_inc_serial(void)
 {
+	pcb_find_island_flush();
 	if (!Locked) {
 		/* Set the changed flag if anything was added prior to this bump */
 		if ((pcb_uundo.tail != NULL) && (pcb_uundo.tail->serial == pcb_uundo.serial))
@@ -142,6 +142,54 @@ pcb_view_t *pcb_view_new(rnd_design_t *hl, const char *type, const char *title,
 	return v;
 }
 
+static fgw_arg_t view_dup_arg(const fgw_arg_t *src)
+{
+	fgw_arg_t a = *src;
+	if (((a.type & FGW_STR) == FGW_STR) && (a.type & FGW_DYN) && (a.val.str != NULL))
+		a.val.str = rnd_strdup(src->val.str);
+	return a;
+}
+
+pcb_view_t *pcb_view_dup(const pcb_view_t *src)
+{
+	pcb_view_t *v = pcb_view_new(src->hidlib, src->type, src->title, src->description);
+	pcb_idpath_t *idp, *nidp;
+	int g;
+
+	v->have_bbox = src->have_bbox;
+	v->have_xy = src->have_xy;
+	v->bbox = src->bbox;
+	v->x = src->x;
+	v->y = src->y;
+
+	for(g = 0; g < 2; g++) {
+		for(idp = pcb_idpath_list_first((pcb_idpath_list_t *)&src->objs[g]); idp != NULL; idp = pcb_idpath_list_next(idp)) {
+			nidp = pcb_idpath_dup(idp);
+			nidp->data_addr = idp->data_addr;
+			nidp->uilayer_addr = idp->uilayer_addr;
+			pcb_idpath_list_append(&v->objs[g], nidp);
+		}
+		if (src->netname[g] != NULL)
+			v->netname[g] = rnd_strdup(src->netname[g]);
+	}
+
+	if (src->long_desc.used > 0) { /* description points into long_desc */
+		free(v->description);
+		gds_append_len(&v->long_desc, src->long_desc.array, src->long_desc.used);
+		v->description = v->long_desc.array;
+	}
+
+	v->data_type = src->data_type;
+	if (src->data_type == PCB_VIEW_DRC) {
+		v->data.drc.have_measured = src->data.drc.have_measured;
+		if (src->data.drc.have_measured)
+			v->data.drc.measured_value = view_dup_arg(&src->data.drc.measured_value);
+		v->data.drc.required_value = view_dup_arg(&src->data.drc.required_value);
+	}
+
+	return v;
+}
+
 void pcb_view_append_obj(pcb_view_t *view, int grp, pcb_any_obj_t *obj)
 {
 	pcb_idpath_t *idp;
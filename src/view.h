@@ -113,6 +113,10 @@ void pcb_view_goto(pcb_view_t *item);
 /* Allocate a new, floating (unlinked) view with no data or bbox */
 pcb_view_t *pcb_view_new(rnd_design_t *hl, const char *type, const char *title, const char *description);
 
+/* Allocate a new, floating (unlinked) view that is a deep copy of src; the
+   copy gets a new uid */
+pcb_view_t *pcb_view_dup(const pcb_view_t *src);
+
 /* Append obj to one of the object groups in view (resolving to idpath) */
 void pcb_view_append_obj(pcb_view_t *view, int grp, pcb_any_obj_t *obj);
 
@@ -42,10 +42,38 @@
 #	define CROUND(c) (c)
 #endif
 
+/* Remove an object from its vector in O(1) by moving the last object in its
+   slot; the index cached in the object is verified because objects may have
+   been appended directly by the caller (raw reconstruction) */
+#define DEF_VT_REMOVE_OBJ(vt_, obj_t) \
+static void vt_ ## _remove_obj(vt_ ## _t *vt, obj_t *obj) \
+{ \
+	size_t i = obj->vtidx; \
+	if ((i >= vt->used) || (vt->array[i] != obj)) { \
+		for(i = 0; i < vt->used; i++) \
+			if (vt->array[i] == obj) \
+				break; \
+		if (i == vt->used) \
+			return; \
+	} \
+	if (vt->elem_destructor != NULL) \
+		vt->elem_destructor(vt, &vt->array[i]); \
+	vt->used--; \
+	if (i < vt->used) { \
+		vt->array[i] = vt->array[vt->used]; \
+		vt->array[i]->vtidx = i; \
+	} \
+}
+
+DEF_VT_REMOVE_OBJ(vtpoint, point_t)
+DEF_VT_REMOVE_OBJ(vtedge, edge_t)
+DEF_VT_REMOVE_OBJ(vttriangle, triangle_t)
+
 static point_t *new_point(cdt_t *cdt, pos_t pos)
 {
 	point_t *p = *vtpoint_alloc_append(&cdt->points, 1);
 	p->pos = pos;
+	p->vtidx = vtpoint_len(&cdt->points) - 1;
 	return p;
 }
 
@@ -54,6 +82,7 @@ static edge_t *new_edge(cdt_t *cdt, point_t *p1, point_t *p2, int constrain)
 	edge_t *e;
 	assert(p1->pos.x != p2->pos.x || p1->pos.y != p2->pos.y);
 	e = *vtedge_alloc_append(&cdt->edges, 1);
+	e->vtidx = vtedge_len(&cdt->edges) - 1;
 	/* always orient the edge to the right (or down when x1==x2; requires epsilon check?) */
 	if (LEFTPOINT(p1, p2)) {
 		e->endp[0] = p1;
@@ -114,6 +143,7 @@ static triangle_t *new_triangle(cdt_t *cdt, point_t *p1, point_t *p2, point_t *p
 	edge_t *e1, *e2, *e3;
 	triangle_t *t = *vttriangle_alloc_append(&cdt->triangles, 1);
 
+	t->vtidx = vttriangle_len(&cdt->triangles) - 1;
 	assert(!ORIENT_COLLINEAR(p1, p2, p3));	/* points cannot be colinear */
 
 	order_triangle_points_ccw(&p1, &p2, &p3);
@@ -181,12 +211,7 @@ static void remove_triangle(cdt_t *cdt, triangle_t *t)
 	}
 
 	/* remove triangle */
-	for(i = 0; i < vttriangle_len(&cdt->triangles); i++) {
-		if (cdt->triangles.array[i] == t) {
-			vttriangle_remove(&cdt->triangles, i, 1);
-			break;
-		}
-	}
+	vttriangle_remove_obj(&cdt->triangles, t);
 }
 
 static void remove_edge(cdt_t *cdt, edge_t *e)
@@ -204,12 +229,7 @@ static void remove_edge(cdt_t *cdt, edge_t *e)
 		e->endp[i]->adj_edges = edgelist_remove_item(e->endp[i]->adj_edges, &e);
 
 	/* remove edge */
-	for(i = 0; i < vtedge_len(&cdt->edges); i++) {
-		if (cdt->edges.array[i] == e) {
-			vtedge_remove(&cdt->edges, i, 1);
-			break;
-		}
-	}
+	vtedge_remove_obj(&cdt->edges, e);
 }
 
 int cdt_is_point_in_circumcircle(point_t *p, triangle_t *t)
@@ -281,6 +301,7 @@ void cdt_init_(cdt_t *cdt)
 	cdt->triangles.elem_destructor = vttriangle_destructor;
 	cdt->triangles.elem_copy = NULL;
 	vttriangle_init(&cdt->triangles);
+	cdt->walk_rnd = 1;
 }
 
 void cdt_init(cdt_t *cdt, coord_t bbox_x1, coord_t bbox_y1, coord_t bbox_x2, coord_t bbox_y2)
@@ -306,6 +327,74 @@ static int is_point_in_triangle(point_t *p, triangle_t *t)
 	return ORIENT_CCW_CL(t->p[0], t->p[1], p) && ORIENT_CCW_CL(t->p[1], t->p[2], p) && ORIENT_CCW_CL(t->p[2], t->p[0], p);
 }
 
+static unsigned long walk_random(cdt_t *cdt)
+{
+	cdt->walk_rnd = cdt->walk_rnd * 1103515245UL + 12345UL;
+	return (cdt->walk_rnd >> 16) & 0x7fff;
+}
+
+/* Jump-and-walk point location: start from the triangle closest to p out of
+   about cbrt(n) sampled ones and the newest one, then keep crossing an edge
+   p is beyond. Edges are tried from a random one so the walk can not cycle
+   in a constrained (non-Delaunay) triangulation. Returns NULL if the walk
+   leaves the triangulation or takes too long. */
+static triangle_t *walk_to_point(cdt_t *cdt, point_t *p)
+{
+	triangle_t *t;
+	size_t num = vttriangle_len(&cdt->triangles), samples, n;
+	double d, best_d;
+	long steps;
+	int i, k;
+
+	if (num == 0)
+		return NULL;
+
+	/* jump */
+	t = cdt->triangles.array[num - 1];
+	best_d = DIST2(t->p[0], p);
+	for (samples = 1; samples * samples * samples < num; samples++) ;
+	for (n = 0; n < samples; n++) {
+		triangle_t *cand = cdt->triangles.array[((walk_random(cdt) << 15) | walk_random(cdt)) % num];
+		d = DIST2(cand->p[0], p);
+		if (d < best_d) {
+			best_d = d;
+			t = cand;
+		}
+	}
+
+	/* walk */
+	for (steps = 0; steps < (long)num + 16; steps++) {
+		int start = walk_random(cdt) % 3;
+		for (k = 0; k < 3; k++) {
+			i = (start + k) % 3;
+			if (ORIENT_CW(t->p[i], t->p[(i + 1) % 3], p)) /* p is beyond edge i */
+				break;
+		}
+		if (k == 3)
+			return t;
+		t = t->adj_t[i];
+		if (t == NULL)
+			return NULL;
+	}
+
+	return NULL;
+}
+
+static triangle_t *find_enclosing_triangle(cdt_t *cdt, point_t *p)
+{
+	triangle_t *t = walk_to_point(cdt, p);
+
+	if (t != NULL)
+		return t;
+
+	/* slow path for points outside of the triangulation */
+	VTTRIANGLE_FOREACH(lt, &cdt->triangles)
+		if (is_point_in_triangle(p, lt))
+			return lt;
+	VTTRIANGLE_FOREACH_END();
+	return NULL;
+}
+
 typedef struct {
 	edgelist_node_t *border_edges;
 	edgelist_node_t *edges_to_remove;
@@ -446,9 +535,8 @@ skip:
 	new_triangle(cdt, p[0], p[1], p[2]);
 }
 
-static int insert_point_(cdt_t *cdt, point_t *new_p)
+static int insert_point_(cdt_t *cdt, point_t *new_p, triangle_t *enclosing_triangle)
 {
-	triangle_t *enclosing_triangle = NULL;
 	retriangulation_region_t region = {NULL, NULL};
 	pointlist_node_t *points_to_attach, *prev_point_node;
 	edge_t *crossing_edge = NULL;
@@ -457,12 +545,8 @@ static int insert_point_(cdt_t *cdt, point_t *new_p)
 	int i, j;
 
 	/* find enclosing triangle */
-	VTTRIANGLE_FOREACH(t, &cdt->triangles)
-		if (is_point_in_triangle(new_p, t)) {
-			enclosing_triangle = t;
-			break;
-		}
-	VTTRIANGLE_FOREACH_END();
+	if (enclosing_triangle == NULL)
+		enclosing_triangle = find_enclosing_triangle(cdt, new_p);
 	if (enclosing_triangle == NULL)
 		return -1;
 
@@ -531,18 +615,23 @@ static int insert_point_(cdt_t *cdt, point_t *new_p)
 
 point_t *cdt_insert_point(cdt_t *cdt, coord_t x, coord_t y)
 {
-	pos_t pos;
-	point_t *new_p;
+	point_t tmp, *new_p;
+	triangle_t *t;
+	int i;
 
-	pos.x = CROUND(x);
-	pos.y = CROUND(y);
-	VTPOINT_FOREACH(p, &cdt->points)
-		if (p->pos.x == pos.x && p->pos.y == pos.y)	/* point in the same pos already exists */
-			return p;
-	VTPOINT_FOREACH_END();
+	tmp.pos.x = CROUND(x);
+	tmp.pos.y = CROUND(y);
 
-	new_p = new_point(cdt, pos);
-	if (insert_point_(cdt, new_p) != 0) {
+	/* a point already in the same pos is a corner of any triangle enclosing pos */
+	t = find_enclosing_triangle(cdt, &tmp);
+	if (t == NULL)
+		return NULL;
+	for (i = 0; i < 3; i++)
+		if (t->p[i]->pos.x == tmp.pos.x && t->p[i]->pos.y == tmp.pos.y)
+			return t->p[i];
+
+	new_p = new_point(cdt, tmp.pos);
+	if (insert_point_(cdt, new_p, t) != 0) {
 		cdt->points.used--; /* new_point() allocated one slot at the end */
 		return NULL;
 	}
@@ -581,12 +670,7 @@ next_i:
 	EDGELIST_FOREACH_END();
 
 	/* remove point */
-	for(i = 0; i < vtpoint_len(&cdt->points); i++) {
-		if (cdt->points.array[i] == p) {
-			vtpoint_remove(&cdt->points, i, 1);
-			break;
-		}
-	}
+	vtpoint_remove_obj(&cdt->points, p);
 
 	polygon_points = order_edges_adjacently(polygon_edges);
 	cdt_triangulate_polygon(cdt, polygon_points);
@@ -789,7 +873,7 @@ next_edge:
 
 	/* reattach isolated points and constrained edges */
 	POINTLIST_FOREACH(p, isolated_points)
-		insert_point_(cdt, p);
+		insert_point_(cdt, p, NULL);
 	POINTLIST_FOREACH_END();
 	pointlist_free(isolated_points);
 	EDGELIST_FOREACH(e, constrained_edges_within_scope)
@@ -50,6 +50,8 @@ struct cdt_s {
 
 	pos_t bbox_tl;
 	pos_t bbox_br;
+
+	unsigned long walk_rnd; /* internal: pseudo-random state for point location */
 };
 
 
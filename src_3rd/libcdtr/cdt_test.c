@@ -429,6 +429,55 @@ static void cmd_dump_triangles(char *args, int anim)
 }
 
 
+/* Insert num (default 100k) pseudo-random points in a new triangulation
+   then delete every 10th of them, measuring the time of both */
+static void cmd_bench(char *args)
+{
+	cdt_t bcdt;
+	point_t **pts;
+	long n, num = 100000, numpts = 0, numdel = 0;
+	unsigned long rnd = 1;
+	clock_t t0, t1, t2;
+
+	if ((*args != '\0') && (sscanf(args, "%ld", &num) != 1)) {
+		fprintf(stderr, "syntax error: bench requires a numeric argument\n");
+		return;
+	}
+	if (num < 1) {
+		fprintf(stderr, "syntax error: bench requires a positive number of points\n");
+		return;
+	}
+
+	pts = malloc(sizeof(point_t *) * num);
+	cdt_init(&bcdt, 0, 0, 1000000, 1000000);
+
+	t0 = clock();
+	for (n = 0; n < num; n++) {
+		coord_t x, y;
+		point_t *p;
+
+		rnd = rnd * 1103515245UL + 12345UL;
+		x = (rnd >> 16) % 999999 + 1;
+		rnd = rnd * 1103515245UL + 12345UL;
+		y = (rnd >> 16) % 999999 + 1;
+		p = cdt_insert_point(&bcdt, x, y);
+		if ((p != NULL) && (p->data == NULL)) { /* skip duplicates */
+			p->data = pts;
+			pts[numpts++] = p;
+		}
+	}
+	t1 = clock();
+	for (n = 0; n < numpts; n += 10, numdel++)
+		cdt_delete_point(&bcdt, pts[n]);
+	t2 = clock();
+
+	printf("bench: inserted %ld points in %.3f s, deleted %ld points in %.3f s; %lu triangles\n",
+		numpts, (double)(t1 - t0) / CLOCKS_PER_SEC, numdel, (double)(t2 - t1) / CLOCKS_PER_SEC, (unsigned long)vttriangle_len(&bcdt.triangles));
+
+	cdt_free(&bcdt);
+	free(pts);
+}
+
 static void cmd_print_events(char *args)
 {
 	switch(*args) {
@@ -499,6 +548,7 @@ static int parse(FILE *f)
 		else if (strcmp(cmd, "dump_triangles_anim") == 0) cmd_dump_triangles(args, 1);
 		else if (strcmp(cmd, "print") == 0) cmd_print(args);
 		else if (strcmp(cmd, "print_events") == 0) cmd_print_events(args);
+		else if (strcmp(cmd, "bench") == 0) cmd_bench(args);
 		else fprintf(stderr, "syntax error: unknown command '%s'\n", cmd);
 	}
 	return 0;
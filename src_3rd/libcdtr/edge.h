@@ -12,6 +12,7 @@ struct edge_s {
 
 	int is_constrained;
 	void *data;
+	size_t vtidx; /* internal: index in cdt->edges for O(1) removal */
 };
 
 typedef edge_t* edge_ptr_t;
@@ -12,6 +12,7 @@ struct point_s {
 	trianglelist_node_t *adj_triangles;
 
 	void *data;
+	size_t vtidx; /* internal: index in cdt->points for O(1) removal */
 };
 
 typedef point_t* point_ptr_t;
@@ -10,6 +10,7 @@ struct triangle_s {
 	point_t *p[3];
 	edge_t *e[3];
 	triangle_t *adj_t[3];
+	size_t vtidx; /* internal: index in cdt->triangles for O(1) removal */
 };
 
 typedef triangle_t* triangle_ptr_t;
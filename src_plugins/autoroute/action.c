@@ -38,7 +38,11 @@
 #include <librnd/hid/hid.h>
 #include <librnd/core/actions.h>
 #include <librnd/core/event.h>
+#include <librnd/core/compat_misc.h>
 #include "funchash_core.h"
+#include "autoroute_conf.h"
+
+conf_autoroute_t conf_autoroute;
 
 static const char pcb_acts_AutoRoute[] = "AutoRoute(AllRats|SelectedRats)";
 static const char pcb_acth_AutoRoute[] = "Auto-route some or all rat lines.";
@@ -70,10 +74,43 @@ static fgw_error_t pcb_act_AutoRoute(fgw_arg_t *res, int argc, fgw_arg_t *argv)
 	return 0;
 }
 
+static const char pcb_acts_AutoRouteCongestion[] = "AutoRouteCongestion(overlay|clear)\nAutoRouteCongestion(csv, filename)";
+static const char pcb_acth_AutoRouteCongestion[] = "Estimate routing congestion of the board per layer group.";
+/* DOC: autoroutecongestion.html */
+static fgw_error_t pcb_act_AutoRouteCongestion(fgw_arg_t *res, int argc, fgw_arg_t *argv)
+{
+	const char *cmd, *fn = NULL;
+	int r;
+
+	RND_ACT_CONVARG(1, FGW_STR, AutoRouteCongestion, cmd = argv[1].val.str);
+	RND_ACT_MAY_CONVARG(2, FGW_STR, AutoRouteCongestion, fn = argv[2].val.str);
+
+	if (rnd_strcasecmp(cmd, "overlay") == 0)
+		r = AutoRouteCongestion(NULL, rnd_true);
+	else if (rnd_strcasecmp(cmd, "csv") == 0) {
+		if (fn == NULL) {
+			rnd_message(RND_MSG_ERROR, "AutoRouteCongestion: csv needs a file name\n");
+			RND_ACT_IRES(-1);
+			return 0;
+		}
+		r = AutoRouteCongestion(fn, rnd_false);
+	}
+	else if (rnd_strcasecmp(cmd, "clear") == 0) {
+		AutoRouteCongestionClear();
+		r = 0;
+	}
+	else
+		RND_ACT_FAIL(AutoRouteCongestion);
+
+	RND_ACT_IRES(r);
+	return 0;
+}
+
 static const char *autoroute_cookie = "autoroute plugin";
 
 rnd_action_t autoroute_action_list[] = {
 	{"AutoRoute", pcb_act_AutoRoute, pcb_acth_AutoRoute, pcb_acts_AutoRoute},
+	{"AutoRouteCongestion", pcb_act_AutoRouteCongestion, pcb_acth_AutoRouteCongestion, pcb_acts_AutoRouteCongestion}
 };
 
 int pplg_check_ver_autoroute(int ver_needed) { return 0; }
@@ -81,11 +118,18 @@ int pplg_check_ver_autoroute(int ver_needed) { return 0; }
 void pplg_uninit_autoroute(void)
 {
 	rnd_remove_actions_by_cookie(autoroute_cookie);
+	AutoRouteCongestionUninit();
+	rnd_conf_unreg_fields("plugins/autoroute/");
 }
 
 int pplg_init_autoroute(void)
 {
 	RND_API_CHK_VER;
+
+#define conf_reg(field,isarray,type_name,cpath,cname,desc,flags) \
+	rnd_conf_reg_field(conf_autoroute, field,isarray,type_name,cpath,cname,desc,flags);
+#include "autoroute_conf_fields.h"
+
 	RND_REGISTER_ACTIONS(autoroute_action_list, autoroute_cookie)
 	return 0;
 }
@@ -89,8 +89,12 @@
 #include "obj_line_draw.h"
 #include "obj_pstk_draw.h"
 #include "obj_pstk_inlines.h"
+#include "layer_ui.h"
+#include "event.h"
+#include <librnd/core/safe_fs.h>
 
 #include "r_legacy.h"
+#include "autoroute_conf.h"
 
 #define autoroute_therm_style 4
 
@@ -320,6 +324,8 @@ typedef struct routedata_s {
 	rnd_coord_t max_bloat;
 	rnd_coord_t max_keep;
 	mtspace_t *mtspace;
+	/* conflict history of plugins/autoroute/negotiated; NULL when off */
+	struct ar_congestion_s *hist;
 } routedata_t;
 
 typedef struct edge_struct_s {
@@ -382,6 +388,8 @@ typedef struct routeone_state_s {
 	/* information about the best path found so far. */
 	routebox_t *best_path, *best_target;
 	rnd_heap_cost_t best_cost;
+	/* conflict history (rd->hist) */
+	struct ar_congestion_s *hist;
 } routeone_state_t;
 
 
@@ -398,6 +406,8 @@ static void add_or_destroy_edge(routeone_state_t *s, edge_t * e);
 static void
 RD_DrawThermal(routedata_t * rd, rnd_coord_t X, rnd_coord_t Y, rnd_cardinal_t group, rnd_cardinal_t layer, routebox_t * subnet, rnd_bool is_bad);
 static void ResetSubnet(routebox_t * net);
+static void ar_cong_hist_add(struct ar_congestion_s *cg, const routebox_t *rb);
+static double ar_cong_hist_penalty(struct ar_congestion_s *cg, const routebox_t *rb);
 #ifdef ROUTE_DEBUG
 static int showboxen = -2;
 static int aabort = 0;
@@ -2401,7 +2411,7 @@ moveable_edge(vector_t * result, const rnd_box_t * box, rnd_direction_t dir,
 		/* and make an expansion edge */
 		nrb->cost_point = rnd_closest_cheap_point_in_box(&nrb->cost_point, &blocker->sbox);
 		nrb->cost +=
-			pcb_cost_to_point_on_layer(&nrb->parent.expansion_area->cost_point, &nrb->cost_point, nrb->group) * CONFLICT_PENALTY(blocker);
+			pcb_cost_to_point_on_layer(&nrb->parent.expansion_area->cost_point, &nrb->cost_point, nrb->group) * CONFLICT_PENALTY(blocker) * ar_cong_hist_penalty(s->hist, blocker);
 
 		ne = CreateEdge(nrb, nrb->cost_point.X, nrb->cost_point.Y, nrb->cost, NULL, RND_ANY_DIR, targets);
 		ne->flags.is_interior = 1;
@@ -3784,6 +3794,7 @@ static routeone_status_t RouteOne(routedata_t * rd, routebox_t * from, routebox_
 	vector_destroy(&source_vec);
 	/* okay, process items from heap until it is empty! */
 	s.best_path = NULL;
+	s.hist = rd->hist;
 	s.best_cost = EXPENSIVE;
 	area_vec = vector_create();
 	edge_vec = vector_create();
@@ -4065,6 +4076,7 @@ static routeone_status_t RouteOne(routedata_t * rd, routebox_t * from, routebox_
 			while (!vector_is_empty(s.best_path->conflicts_with)) {
 				rb = (routebox_t *) vector_remove_last(s.best_path->conflicts_with);
 				rb->flags.is_bad = 1;
+				ar_cong_hist_add(rd->hist, rb);
 				result.route_had_conflicts++;
 			}
 		}
@@ -4150,7 +4162,9 @@ static void InitAutoRouteParameters(int pass, pcb_route_style_t * style, rnd_boo
 	AutoRouteParameters.pass = pass + 1;
 }
 
-#ifndef NDEBUG
+#ifdef ROUTE_DEBUG
+/* walks all routeboxes of the board: too expensive to run before each
+   RouteOne() in regular builds */
 rnd_rtree_dir_t bad_boy(void *cl, void *obj, const rnd_rtree_box_t *box_)
 {
 	routebox_t *box = (routebox_t *)box_;
@@ -4223,6 +4237,8 @@ static double calculate_progress(double this_heap_item, double this_heap_size, s
 	return process_fraction;
 }
 
+#include "congestion.c"
+
 struct routeall_status RouteAll(routedata_t * rd)
 {
 	struct routeall_status ras;
@@ -4233,36 +4249,47 @@ struct routeall_status RouteAll(routedata_t * rd)
 	rnd_heap_t *net_heap;
 #endif
 	rnd_heap_t *this_pass, *next_pass, *tmp;
+	ar_congestion_t cg;
 	routebox_t *net, *p, *pp;
 	rnd_heap_cost_t total_net_cost, last_cost = 0, this_cost = 0;
 	int i;
 	int this_heap_size;
 	int this_heap_item;
+	int cong_order, negotiated;
 
 	/* initialize heap for first pass;
 	 * do smallest area first; that makes
-	 * the subsequent costs more representative */
+	 * the subsequent costs more representative;
+	 * with plugins/autoroute/congestion_order nets crossing congested
+	 * regions are moved forward so that they are routed while there is
+	 * still room for them;
+	 * with plugins/autoroute/negotiated the grid is kept for the whole
+	 * process to collect the conflict history of the refinement passes */
 	this_pass = rnd_heap_create();
 	next_pass = rnd_heap_create();
 #ifdef NET_HEAP
 	net_heap = rnd_heap_create();
 #endif
+	cong_order = conf_autoroute.plugins.autoroute.congestion_order;
+	negotiated = conf_autoroute.plugins.autoroute.negotiated;
+	if (cong_order || negotiated)
+		ar_cong_init(&cg, rd);
 	LIST_LOOP(rd->first_net, different_net, net);
 	{
 		double area;
-		rnd_box_t bb = shrink_routebox(net);
-		LIST_LOOP(net, same_net, p);
-		{
-			RND_MAKE_MIN(bb.X1, p->sbox.X1);
-			RND_MAKE_MIN(bb.Y1, p->sbox.Y1);
-			RND_MAKE_MAX(bb.X2, p->sbox.X2);
-			RND_MAKE_MAX(bb.Y2, p->sbox.Y2);
-		}
-		PCB_END_LOOP;
+		rnd_box_t bb = ar_cong_net_bbox(net);
 		area = (double) (bb.X2 - bb.X1) * (bb.Y2 - bb.Y1);
+		if (cong_order)
+			area /= 1.0 + ar_cong_util_box(&cg, &bb);
 		rnd_heap_insert(this_pass, area, net);
 	}
 	PCB_END_LOOP;
+	if (negotiated) {
+		ar_cong_hist_alloc(&cg);
+		rd->hist = &cg;
+	}
+	else if (cong_order)
+		ar_cong_uninit(&cg);
 
 	ras.total_nets_routed = 0;
 	/* refinement/finishing passes */
@@ -4378,7 +4405,12 @@ struct routeall_status RouteAll(routedata_t * rd)
 				while (!ros.net_completely_routed) {
 					double percent;
 
+#ifdef ROUTE_DEBUG
 					assert(no_expansion_boxes(rd));
+#endif
+					/* all expansion areas are collected on area_vec and removed
+					   from the r-trees by the end of RouteOne() */
+					assert(area_vec == NULL);
 					/* FIX ME: the number of edges to examine should be in autoroute parameters
 					 * i.e. the 2000 and 800 hard-coded below should be controllable by the user
 					 */
@@ -4465,6 +4497,10 @@ struct routeall_status RouteAll(routedata_t * rd)
 	rnd_message(RND_MSG_INFO, "%d of %d nets successfully routed.\n", ras.routed_subnets, ras.total_subnets);
 
 out:
+	if (negotiated) {
+		rd->hist = NULL;
+		ar_cong_uninit(&cg);
+	}
 	rnd_heap_destroy(&this_pass);
 	rnd_heap_destroy(&next_pass);
 #ifdef NET_HEAP
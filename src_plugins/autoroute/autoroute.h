@@ -43,4 +43,11 @@
 
 rnd_bool AutoRoute(rnd_bool);
 
+/* Estimate routing congestion of the board; save it in CSV if csv_fn is
+   not NULL and/or draw it on a ui layer if overlay is true. Returns 0 on
+   success. */
+int AutoRouteCongestion(const char *csv_fn, rnd_bool overlay);
+void AutoRouteCongestionClear(void);
+void AutoRouteCongestionUninit(void);
+
 #endif
@@ -0,0 +1,17 @@
+#ifndef PCB_AUTOROUTE_CONF_H
+#define PCB_AUTOROUTE_CONF_H
+
+#include <librnd/core/conf.h>
+
+typedef struct {
+	const struct plugins {
+		const struct autoroute {
+			RND_CFT_BOOLEAN congestion_order;   /* first pass: route nets crossing congested regions earlier (net bbox area is divided by the estimated congestion of the bbox); when false, nets are routed in order of bbox area only */
+			RND_CFT_BOOLEAN negotiated;         /* refinement passes: remember where routes conflicted with other nets and make routing over other nets' traces in those regions more expensive on each later pass (negotiated congestion); when false, the conflict penalty depends only on the pass */
+		} autoroute;
+	} plugins;
+} conf_autoroute_t;
+
+extern conf_autoroute_t conf_autoroute;
+
+#endif
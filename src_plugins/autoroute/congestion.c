@@ -0,0 +1,379 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  pcb-rnd, interactive printed circuit board design
+ *  Copyright (C) 2024 Tibor 'Igor2' Palinkas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  Contact:
+ *    Project page: http://repo.hu/projects/pcb-rnd
+ *    lead developer: http://repo.hu/projects/pcb-rnd/contact.html
+ *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
+ */
+
+/* Congestion estimation: a coarse demand/capacity map per layer group,
+   independent of any routing grid. Capacity is the area of a cell not
+   covered by the fixed obstacles of the group (the same boxes the via
+   free-space of mtspace is built from). Demand is the routing area unrouted
+   nets are expected to need: the half perimeter of the net's bounding box
+   times the track pitch, spread evenly over the bounding box and the active
+   layer groups. The same grid collects the conflict history of the
+   negotiated congestion mode. Included from autoroute.c. */
+
+#define AR_CONG_CELLS 64 /* number of cells along the longer side of the board */
+#define AR_CONG_HIST_MAX 16 /* upper limit of the conflict penalty multiplier from the history */
+
+typedef struct ar_congestion_s {
+	rnd_coord_t x0, y0, cell;  /* grid origin and cell size */
+	int nx, ny, ngrp;
+	double *demand;            /* [grp][y][x] routing area needed by unrouted nets */
+	double *obst;              /* [grp][y][x] area covered by fixed obstacles */
+	float *hist;               /* [grp][y][x] number of conflicts in previous passes; NULL if not collected */
+} ar_congestion_t;
+
+#define AR_CONG_IDX(cg, g, x, y) ((((long)(g) * (cg)->ny) + (y)) * (cg)->nx + (x))
+
+/* Loop over the cells overlapping box; area is the area of the overlap */
+#define AR_CONG_FOREACH_OVERLAP(cg, box, x, y, area) \
+do { \
+	rnd_coord_t x1_ = ((box)->X1 - (cg)->x0) / (cg)->cell, y1_ = ((box)->Y1 - (cg)->y0) / (cg)->cell; \
+	rnd_coord_t x2_ = ((box)->X2 - (cg)->x0) / (cg)->cell, y2_ = ((box)->Y2 - (cg)->y0) / (cg)->cell; \
+	if (x1_ < 0) x1_ = 0; \
+	if (y1_ < 0) y1_ = 0; \
+	if (x2_ >= (cg)->nx) x2_ = (cg)->nx - 1; \
+	if (y2_ >= (cg)->ny) y2_ = (cg)->ny - 1; \
+	for(y = y1_; y <= y2_; y++) { \
+		rnd_coord_t cy1_ = (cg)->y0 + y * (cg)->cell, cy2_ = cy1_ + (cg)->cell; \
+		double h_ = (double)(MIN(cy2_, (box)->Y2) - MAX(cy1_, (box)->Y1)); \
+		if (h_ <= 0) continue; \
+		for(x = x1_; x <= x2_; x++) { \
+			rnd_coord_t cx1_ = (cg)->x0 + x * (cg)->cell, cx2_ = cx1_ + (cg)->cell; \
+			double w_ = (double)(MIN(cx2_, (box)->X2) - MAX(cx1_, (box)->X1)); \
+			if (w_ <= 0) continue; \
+			area = w_ * h_;
+
+#define AR_CONG_FOREACH_OVERLAP_END \
+		} \
+	} \
+} while(0)
+
+static rnd_rtree_dir_t ar_cong_obst_cb(void *cl, void *obj, const rnd_rtree_box_t *box)
+{
+	ar_congestion_t *cg = cl;
+	routebox_t *rb = (routebox_t *)box;
+	double area;
+	int x, y;
+
+	/* polygons that are cleared by the tracks are not obstacles */
+	if ((rb->type == EXPANSION_AREA) || rb->flags.clear_poly)
+		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+
+	AR_CONG_FOREACH_OVERLAP(cg, &rb->box, x, y, area)
+		cg->obst[AR_CONG_IDX(cg, rb->group, x, y)] += area;
+	AR_CONG_FOREACH_OVERLAP_END;
+
+	return rnd_RTREE_DIR_FOUND_CONT;
+}
+
+static rnd_box_t ar_cong_net_bbox(routebox_t *net)
+{
+	routebox_t *p;
+	rnd_box_t bb = shrink_routebox(net);
+
+	LIST_LOOP(net, same_net, p);
+	{
+		RND_MAKE_MIN(bb.X1, p->sbox.X1);
+		RND_MAKE_MIN(bb.Y1, p->sbox.Y1);
+		RND_MAKE_MAX(bb.X2, p->sbox.X2);
+		RND_MAKE_MAX(bb.Y2, p->sbox.Y2);
+	}
+	PCB_END_LOOP;
+
+	return bb;
+}
+
+static void ar_cong_add_net(ar_congestion_t *cg, routebox_t *net)
+{
+	routebox_t *p;
+	rnd_box_t bb;
+	rnd_coord_t pitch;
+	double need, density, area;
+	int subnets = 0, g, x, y;
+
+	FOREACH_SUBNET(net, p);
+	subnets++;
+	END_FOREACH(net, p);
+	if ((subnets < 2) || (routing_layers == 0))
+		return;
+
+	bb = ar_cong_net_bbox(net);
+	pitch = net->style->Thick + net->style->Clearance;
+	/* degenerate (straight) nets still need a track */
+	if (bb.X2 - bb.X1 < pitch) {
+		bb.X1 -= pitch / 2;
+		bb.X2 = bb.X1 + pitch;
+	}
+	if (bb.Y2 - bb.Y1 < pitch) {
+		bb.Y1 -= pitch / 2;
+		bb.Y2 = bb.Y1 + pitch;
+	}
+
+	need = (double)((bb.X2 - bb.X1) + (bb.Y2 - bb.Y1)) * (double)pitch;
+	density = need / ((double)(bb.X2 - bb.X1) * (double)(bb.Y2 - bb.Y1) * (double)routing_layers);
+
+	AR_CONG_FOREACH_OVERLAP(cg, &bb, x, y, area)
+		for(g = 0; g < cg->ngrp; g++)
+			if (is_layer_group_active[g])
+				cg->demand[AR_CONG_IDX(cg, g, x, y)] += density * area;
+	AR_CONG_FOREACH_OVERLAP_END;
+}
+
+static void ar_cong_init(ar_congestion_t *cg, routedata_t *rd)
+{
+	rnd_box_t big;
+	rnd_coord_t w = PCB->hidlib.dwg.X2 - PCB->hidlib.dwg.X1, h = PCB->hidlib.dwg.Y2 - PCB->hidlib.dwg.Y1;
+	routebox_t *net;
+	long len;
+	int g;
+
+	cg->x0 = PCB->hidlib.dwg.X1;
+	cg->y0 = PCB->hidlib.dwg.Y1;
+	cg->cell = (MAX(w, h) + AR_CONG_CELLS - 1) / AR_CONG_CELLS;
+	if (cg->cell < 1)
+		cg->cell = 1;
+	cg->nx = (w + cg->cell - 1) / cg->cell;
+	cg->ny = (h + cg->cell - 1) / cg->cell;
+	if (cg->nx < 1) cg->nx = 1;
+	if (cg->ny < 1) cg->ny = 1;
+	cg->ngrp = pcb_max_group(PCB);
+
+	len = (long)cg->ngrp * cg->nx * cg->ny;
+	cg->demand = calloc(sizeof(double), len);
+	cg->obst = calloc(sizeof(double), len);
+	cg->hist = NULL;
+
+	big.X1 = big.Y1 = -RND_MAX_COORD;
+	big.X2 = big.Y2 = RND_MAX_COORD;
+	for(g = 0; g < cg->ngrp; g++)
+		if (is_layer_group_active[g])
+			rnd_rtree_search_any(rd->layergrouptree[g], (rnd_rtree_box_t *)&big, NULL, ar_cong_obst_cb, cg, NULL);
+
+	LIST_LOOP(rd->first_net, different_net, net);
+	ar_cong_add_net(cg, net);
+	PCB_END_LOOP;
+}
+
+static void ar_cong_uninit(ar_congestion_t *cg)
+{
+	free(cg->demand);
+	free(cg->obst);
+	free(cg->hist);
+	cg->demand = cg->obst = NULL;
+	cg->hist = NULL;
+}
+
+/* Fraction of the routing area of a cell that is taken by obstacles or
+   needed by unrouted nets; above 1 the cell is over-subscribed */
+static double ar_cong_util(ar_congestion_t *cg, int g, int x, int y)
+{
+	double cell_area = (double)cg->cell * (double)cg->cell;
+	long i = AR_CONG_IDX(cg, g, x, y);
+	double obst = MIN(cg->obst[i], cell_area);
+
+	return (obst + cg->demand[i]) / cell_area;
+}
+
+/* Worst utilization over all active layer groups */
+static double ar_cong_util_max(ar_congestion_t *cg, int x, int y)
+{
+	double u, best = 0;
+	int g;
+
+	for(g = 0; g < cg->ngrp; g++) {
+		if (!is_layer_group_active[g])
+			continue;
+		u = ar_cong_util(cg, g, x, y);
+		if (u > best)
+			best = u;
+	}
+	return best;
+}
+
+/* Average of the worst utilization of the cells under box */
+static double ar_cong_util_box(ar_congestion_t *cg, const rnd_box_t *box)
+{
+	double area, sum = 0, total = 0;
+	int x, y;
+
+	AR_CONG_FOREACH_OVERLAP(cg, box, x, y, area)
+		sum += ar_cong_util_max(cg, x, y) * area;
+		total += area;
+	AR_CONG_FOREACH_OVERLAP_END;
+
+	return (total > 0) ? sum / total : 0;
+}
+
+static int ar_cong_save_csv(ar_congestion_t *cg, const char *fn)
+{
+	double cell_area = (double)cg->cell * (double)cg->cell;
+	FILE *f;
+	int g, x, y;
+
+	f = rnd_fopen(&PCB->hidlib, fn, "w");
+	if (f == NULL) {
+		rnd_message(RND_MSG_ERROR, "autoroute congestion: can't open %s for write\n", fn);
+		return -1;
+	}
+
+	fprintf(f, "group,name,x1,y1,x2,y2,obstacle,demand,utilization\n");
+	for(g = 0; g < cg->ngrp; g++) {
+		if (!is_layer_group_active[g])
+			continue;
+		for(y = 0; y < cg->ny; y++) {
+			for(x = 0; x < cg->nx; x++) {
+				rnd_coord_t x1 = cg->x0 + x * cg->cell, y1 = cg->y0 + y * cg->cell;
+				long i = AR_CONG_IDX(cg, g, x, y);
+				rnd_fprintf(f, "%d,%s,%mm,%mm,%mm,%mm,%.4f,%.4f,%.4f\n", g, PCB->LayerGroups.grp[g].name,
+					x1, y1, x1 + cg->cell, y1 + cg->cell,
+					MIN(cg->obst[i], cell_area) / cell_area, cg->demand[i] / cell_area, ar_cong_util(cg, g, x, y));
+			}
+		}
+	}
+
+	fclose(f);
+	return 0;
+}
+
+/*** negotiated congestion ***/
+
+static void ar_cong_hist_alloc(ar_congestion_t *cg)
+{
+	cg->hist = calloc(sizeof(float), (long)cg->ngrp * cg->nx * cg->ny);
+}
+
+/* A route of the current pass conflicts with rb: remember the region of rb
+   as over-used; cg is NULL when the history is not collected */
+static void ar_cong_hist_add(ar_congestion_t *cg, const routebox_t *rb)
+{
+	double area;
+	int x, y;
+
+	if (cg == NULL)
+		return;
+
+	AR_CONG_FOREACH_OVERLAP(cg, &rb->sbox, x, y, area)
+		(void)area;
+		cg->hist[AR_CONG_IDX(cg, rb->group, x, y)] += 1;
+	AR_CONG_FOREACH_OVERLAP_END;
+}
+
+/* Multiplier of the penalty of routing over rb: grows with the number of
+   conflicts recorded in the worst cell under rb, so that nets negotiate
+   their way out of regions that keep conflicting pass after pass */
+static double ar_cong_hist_penalty(ar_congestion_t *cg, const routebox_t *rb)
+{
+	double area;
+	float h = 0;
+	int x, y;
+
+	if (cg == NULL)
+		return 1.0;
+
+	AR_CONG_FOREACH_OVERLAP(cg, &rb->sbox, x, y, area)
+		(void)area;
+		RND_MAKE_MAX(h, cg->hist[AR_CONG_IDX(cg, rb->group, x, y)]);
+	AR_CONG_FOREACH_OVERLAP_END;
+
+	return 1.0 + MIN(h, AR_CONG_HIST_MAX - 1);
+}
+
+/*** overlay ***/
+
+static const char *ar_congestion_cookie = "autoroute congestion";
+static pcb_layer_t *ar_cong_layer;
+
+static void ar_cong_overlay_clear(void)
+{
+	if (ar_cong_layer == NULL)
+		return;
+	pcb_uilayer_free(ar_cong_layer);
+	ar_cong_layer = NULL;
+}
+
+/* One dot per cell that is at least half full; the dot fills the cell
+   when the cell is over-subscribed by 50% */
+static void ar_cong_overlay(ar_congestion_t *cg)
+{
+	static rnd_color_t clr;
+	int x, y;
+
+	if (clr.str[0] != '#')
+		rnd_color_load_str(&clr, "#ff0000");
+
+	ar_cong_overlay_clear();
+	ar_cong_layer = pcb_uilayer_alloc(PCB, ar_congestion_cookie, "autoroute congestion", &clr);
+
+	for(y = 0; y < cg->ny; y++) {
+		for(x = 0; x < cg->nx; x++) {
+			double u = ar_cong_util_max(cg, x, y);
+			rnd_coord_t cx = cg->x0 + x * cg->cell + cg->cell / 2, cy = cg->y0 + y * cg->cell + cg->cell / 2;
+			if (u < 0.5)
+				continue;
+			pcb_line_new(ar_cong_layer, cx, cy, cx, cy, (rnd_coord_t)((double)cg->cell * MIN(u, 1.5) / 1.5), 0, pcb_no_flags());
+		}
+	}
+}
+
+int AutoRouteCongestion(const char *csv_fn, rnd_bool overlay)
+{
+	routedata_t *rd;
+	ar_congestion_t cg;
+	int res = 0;
+
+	rd = CreateRouteData();
+	if (rd == NULL) {
+		rnd_message(RND_MSG_ERROR, "Failed to initialize data; might be missing\n" "top or bottom copper layer.\n");
+		return -1;
+	}
+
+	ar_cong_init(&cg, rd);
+	if (csv_fn != NULL)
+		res |= ar_cong_save_csv(&cg, csv_fn);
+	if (overlay) {
+		ar_cong_overlay(&cg);
+		rnd_event(&PCB->hidlib, PCB_EVENT_LAYERS_CHANGED, NULL);
+		rnd_hid_redraw(&PCB->hidlib);
+	}
+	ar_cong_uninit(&cg);
+
+	DestroyRouteData(&rd);
+	return res;
+}
+
+void AutoRouteCongestionClear(void)
+{
+	if (ar_cong_layer == NULL)
+		return;
+	ar_cong_overlay_clear();
+	rnd_event(&PCB->hidlib, PCB_EVENT_LAYERS_CHANGED, NULL);
+	rnd_hid_redraw(&PCB->hidlib);
+}
+
+void AutoRouteCongestionUninit(void)
+{
+	pcb_uilayer_free_all_cookie(ar_congestion_cookie);
+	ar_cong_layer = NULL;
+}
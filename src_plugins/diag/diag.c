@@ -39,6 +39,7 @@
 #include <librnd/core/conf.h>
 #include <librnd/core/error.h>
 #include <librnd/core/event.h>
+#include <librnd/core/safe_fs.h>
 #include "integrity.h"
 #include <librnd/hid/hid.h>
 #include <librnd/hid/hid_attrib.h>
@@ -48,6 +49,7 @@
 #include "plug_io.h"
 #include "funchash_core.h"
 #include "conf_core.h"
+#include "polygon.h"
 
 conf_diag_t conf_diag;
 
@@ -364,6 +366,152 @@ static fgw_error_t pcb_act_Find2Perf(fgw_arg_t *res, int argc, fgw_arg_t *argv)
 	return 0;
 }
 
+static const char pcb_acts_ClipPerf[] = "ClipPerf([tiles])\n";
+static const char pcb_acth_ClipPerf[] = "Measure the peformance of clipping all polygons of the board with the pairwise batch union (no tiling) and with the tiled clearance union using tiles*tiles tiles (default: design/poly_clip_tiles or 8)";
+static fgw_error_t pcb_act_ClipPerf(fgw_arg_t *res, int argc, fgw_arg_t *argv)
+{
+	int tiles = conf_core.design.poly_clip_tiles, old_tiles;
+	long polys = 0;
+	double t0, t1, t2;
+
+	RND_ACT_MAY_CONVARG(1, FGW_INT, ClipPerf, tiles = argv[1].val.nat_int);
+	if (tiles <= 0)
+		tiles = 8;
+
+	PCB_POLY_ALL_LOOP(PCB->Data) {
+		polys++;
+	}
+	PCB_ENDALL_LOOP;
+
+	rnd_message(RND_MSG_INFO, "Measuring poly clip peformance on %ld polygons...\n", polys);
+
+	old_tiles = pcb_poly_clip_tiles_override(0);
+	t0 = rnd_dtime();
+	pcb_data_clip_all(PCB->Data, rnd_false);
+	t1 = rnd_dtime();
+
+	pcb_poly_clip_tiles_override(tiles);
+	pcb_data_clip_all(PCB->Data, rnd_false);
+	t2 = rnd_dtime();
+
+	pcb_poly_clip_tiles_override(old_tiles);
+
+	rnd_message(RND_MSG_INFO, "poly clip peformance: %f s pairwise batch union, %f s with %dx%d tiles\n", t1 - t0, t2 - t1, tiles, tiles);
+	rnd_hid_redraw(&PCB->hidlib);
+	RND_ACT_IRES(0);
+	return 0;
+}
+
+static rnd_rtree_dir_t rtree_perf_cb(void *cl, void *obj, const rnd_rtree_box_t *box)
+{
+	long *hits = cl;
+	(*hits)++;
+	return rnd_RTREE_DIR_FOUND_CONT;
+}
+
+/* search the bbox of each object of the board in all trees */
+static double rtree_perf_query(int passes, long *hits)
+{
+	pcb_data_it_t it;
+	pcb_any_obj_t *o;
+	double t0 = rnd_dtime();
+	int n;
+
+	*hits = 0;
+	for(n = 0; n < passes; n++)
+		for(o = pcb_data_first(&it, PCB->Data, PCB_OBJ_CLASS_REAL); o != NULL; o = pcb_data_next(&it))
+			pcb_data_r_search(PCB->Data, PCB_OBJ_CLASS_REAL, (rnd_rtree_box_t *)&o->BoundingBox, NULL, rtree_perf_cb, hits, NULL, rnd_false);
+
+	return rnd_dtime() - t0;
+}
+
+static const char pcb_acts_RtreePerf[] = "RtreePerf([passes])\n";
+static const char pcb_acth_RtreePerf[] = "Measure the peformance of rtree queries on the board as loaded, the time it takes to repack all rtrees and the peformance of the same queries on the repacked rtrees";
+static fgw_error_t pcb_act_RtreePerf(fgw_arg_t *res, int argc, fgw_arg_t *argv)
+{
+	int passes = 1;
+	long hits1, hits2;
+	double tq1, tq2, tr;
+
+	RND_ACT_MAY_CONVARG(1, FGW_INT, RtreePerf, passes = argv[1].val.nat_int);
+	if (passes <= 0)
+		passes = 1;
+
+	tq1 = rtree_perf_query(passes, &hits1);
+	tr = rnd_dtime();
+	pcb_data_rtree_repack(PCB->Data);
+	tr = rnd_dtime() - tr;
+	tq2 = rtree_perf_query(passes, &hits2);
+
+	rnd_message(RND_MSG_INFO, "rtree peformance: queries: %f s (%ld hits) before repack, %f s (%ld hits) after; repack: %f s\n", tq1, hits1, tq2, hits2, tr);
+	RND_ACT_IRES(0);
+	return 0;
+}
+
+/* load fn passes times into a scratch board; returns the average load time
+   or -1 on error */
+static double load_perf(const char *fn, const char *fmt, int passes)
+{
+	pcb_board_t *orig = PCB, *tmp;
+	double t0, sum = 0;
+	int n, r;
+
+	for(n = 0; n < passes; n++) {
+		tmp = pcb_board_new_(rnd_false);
+		PCB = tmp;
+		pcb_layergrp_inhibit_inc();
+		t0 = rnd_dtime();
+		r = pcb_parse_pcb(tmp, fn, fmt, RND_CFR_invalid, 0);
+		sum += rnd_dtime() - t0;
+		pcb_layergrp_inhibit_dec();
+		PCB = orig;
+		pcb_board_free(tmp);
+		free(tmp);
+		if (r != 0)
+			return -1;
+	}
+	return sum / (double)passes;
+}
+
+static const char pcb_acts_LoadPerf[] = "LoadPerf([passes])\n";
+static const char pcb_acth_LoadPerf[] = "Save the board in lihata and in lhtsnap (binary snapshot) format to temporary files and measure the average time of loading each";
+static fgw_error_t pcb_act_LoadPerf(fgw_arg_t *res, int argc, fgw_arg_t *argv)
+{
+	int passes = 1;
+	double tl = -1, ts = -1;
+	char *fnl, *fns;
+
+	RND_ACT_MAY_CONVARG(1, FGW_INT, LoadPerf, passes = argv[1].val.nat_int);
+	if (passes <= 0)
+		passes = 1;
+
+	fnl = rnd_tempfile_name_new("loadperf.lht");
+	fns = rnd_tempfile_name_new("loadperf.lhtsnap");
+	if ((fnl == NULL) || (fns == NULL)) {
+		rnd_message(RND_MSG_ERROR, "LoadPerf: failed to create temporary file\n");
+		goto quit;
+	}
+
+	if ((pcb_write_pcb_file(fnl, rnd_true, "lihata", rnd_false, rnd_false, -1, 0) != 0) || (pcb_write_pcb_file(fns, rnd_true, "lhtsnap", rnd_false, rnd_false, -1, 0) != 0)) {
+		rnd_message(RND_MSG_ERROR, "LoadPerf: failed to save the board\n");
+		goto quit;
+	}
+
+	tl = load_perf(fnl, "lihata", passes);
+	ts = load_perf(fns, "lhtsnap", passes);
+	if ((tl < 0) || (ts < 0))
+		rnd_message(RND_MSG_ERROR, "LoadPerf: failed to load the board back\n");
+	else
+		rnd_message(RND_MSG_INFO, "load peformance: %f s lihata, %f s lhtsnap (average of %d loads)\n", tl, ts, passes);
+
+	quit:;
+	if (fnl != NULL)
+		rnd_tempfile_unlink(fnl);
+	if (fns != NULL)
+		rnd_tempfile_unlink(fns);
+	RND_ACT_IRES(((tl < 0) || (ts < 0)) ? 1 : 0);
+	return 0;
+}
 
 #define DLF_PREFIX "<DumpLibFootprint> "
 #define SCRATCH pcb_buffers[PCB_MAX_BUFFER-1]
@@ -460,6 +608,9 @@ rnd_action_t diag_action_list[] = {
 #endif
 	{"d1", pcb_act_d1, pcb_acth_d1, pcb_acts_d1},
 	{"find2perf", pcb_act_Find2Perf, pcb_acth_Find2Perf, pcb_acts_Find2Perf},
+	{"ClipPerf", pcb_act_ClipPerf, pcb_acth_ClipPerf, pcb_acts_ClipPerf},
+	{"RtreePerf", pcb_act_RtreePerf, pcb_acth_RtreePerf, pcb_acts_RtreePerf},
+	{"LoadPerf", pcb_act_LoadPerf, pcb_acth_LoadPerf, pcb_acts_LoadPerf},
 	{"integrity", pcb_act_integrity, integrity_help, integrity_syntax},
 	{"dumpflags", pcb_act_dumpflags, pcb_acth_dumpflags, pcb_acts_dumpflags},
 	{"dumpids", pcb_act_DumpIDs, pcb_acth_DumpIDs, pcb_acts_DumpIDs},
@@ -284,6 +284,22 @@ static void create_lib_tree_model_recurse(rnd_hid_attribute_t *attr, pcb_fplibra
 	}
 }
 
+/* Load a lazy library dir on first click and add its rows under row */
+static void library_expand_row(library_ctx_t *ctx, rnd_hid_row_t *row)
+{
+	pcb_fplibrary_t *l = row->user_data;
+	rnd_hid_attribute_t *attr = &ctx->dlg[ctx->wtree];
+
+	if ((l == NULL) || (l->type != PCB_LIB_DIR) || (l->data.dir.lazy == NULL))
+		return;
+
+	if (pcb_fp_lib_expand(l) != 0)
+		return;
+
+	create_lib_tree_model_recurse(attr, l, row);
+	rnd_dad_tree_expcoll(attr, row, 1, 0);
+}
+
 
 static void library_lib2dlg(library_ctx_t *ctx)
 {
@@ -330,6 +346,7 @@ static void library_select(rnd_hid_attribute_t *attrib, void *hid_ctx, rnd_hid_r
 	library_update_preview(ctx, NULL, NULL);
 	if (row != NULL) {
 		pcb_fplibrary_t *l = row->user_data;
+		library_expand_row(ctx, row);
 		if ((l != NULL) && (l->type == PCB_LIB_FOOTPRINT)) {
 			if ((l->data.fp.type == PCB_FP_PARAMETRIC)) {
 				if (last != l) { /* first click */
@@ -450,6 +467,10 @@ static void library_filter_cb(void *hid_ctx, void *caller_data, rnd_hid_attribut
 	if (is_para)
 		goto skip_filter;
 
+	/* searching needs the whole library: load lazy dirs and rebuild the tree */
+	if (have_filter_text && (pcb_fp_lib_expand_all(&pcb_library) > 0))
+		library_lib2dlg(ctx);
+
 	/* hide or unhide everything */
 
 	if (have_filter_text) {
@@ -53,11 +53,13 @@
 #include "conf_core.h"
 #include "find.h"
 #include "event.h"
+#include "undo.h"
 
 #include "drc_query_conf.h"
 #include "../src_plugins/drc_query/conf_internal.c"
 #include "../src_plugins/query/query.h"
 #include "../src_plugins/query/query_exec.h"
+#include "../src_plugins/query/query_plan.h"
 
 
 static void drc_rlist_pcb2dlg(void);
@@ -70,6 +72,8 @@ static const char *drc_query_cookie = "drc_query";
 
 extern conf_drc_query_t conf_drc_query;
 
+#include "drc_query_cache.c"
+
 #define DRC_CONF_PATH_RULES_NODE "plugins/drc_query/rules"
 
 #define DRC_CONF_PATH_PLUGIN "plugins/drc_query/"
@@ -184,7 +188,9 @@ static long drc_qry_exec(pcb_qry_exec_t *ec, pcb_board_t *pcb, pcb_view_list_t *
 	drc_query_prog_t *prog = ec->progress_ctx;
 	drc_qry_ctx_t qctx;
 	pcb_drcq_stat_t *st;
+	pcb_view_t *last_before;
 	double ts, te;
+	long cached;
 
 	if ((prog != 0) && (prog->cancel))
 		return 0;
@@ -208,9 +214,20 @@ static long drc_qry_exec(pcb_qry_exec_t *ec, pcb_board_t *pcb, pcb_view_list_t *
 
 	st = pcb_drcq_stat_get(name);
 
+	cached = pcb_drcq_cache_apply(pcb, name, type, title, desc, query, lst);
+	if (cached >= 0) {
+		st->last_hit_cnt = cached;
+		if (prog != NULL)
+			prog->qctx = 0;
+		return 0;
+	}
+
+	last_before = pcb_view_list_last(lst);
 	ts = rnd_dtime();
 	pcb_qry_run_script(ec, pcb, query, scope, drc_qry_exec_cb, &qctx);
 	te = rnd_dtime();
+	if ((prog == NULL) || !prog->cancel)
+		pcb_drcq_cache_store(pcb, name, type, title, desc, query, lst, last_before);
 
 	st->last_run_time = te - ts;
 	st->sum_run_time += te - ts;
@@ -261,6 +278,7 @@ static void pcb_drc_query(rnd_design_t *hidlib, void *user_data, int argc, rnd_e
 		return;
 
 	pcb_qry_init(&ec, pcb, NULL, bufno);
+	pcb_find_cache_begin(pcb); /* rules don't change the board; share connectivity between them */
 	ec.progress_cb = drc_query_progress;
 	ec.progress_ctx = &prog;
 
@@ -295,6 +313,7 @@ static void pcb_drc_query(rnd_design_t *hidlib, void *user_data, int argc, rnd_e
 
 	drc_query_progress(&ec, -1, -1);
 
+	pcb_find_cache_end(pcb);
 	pcb_qry_uninit(&ec);
 	drc_rlist_pcb2dlg(); /* for the run time */
 }
@@ -302,6 +321,10 @@ static void pcb_drc_query(rnd_design_t *hidlib, void *user_data, int argc, rnd_e
 static void drc_query_refresh_def(void);
 static void drc_query_defchg(rnd_conf_native_t *cfg, int v, void *user_data)
 {
+	if (strncmp(cfg->hash_path, DRC_CONF_PATH_CONST, strlen(DRC_CONF_PATH_CONST)) == 0)
+		pcb_drcq_cache_drop_def(cfg->hash_path + strlen(DRC_CONF_PATH_CONST));
+	else
+		pcb_drcq_cache_flush();
 	drc_query_refresh_def();
 }
 
@@ -879,6 +902,55 @@ static fgw_error_t pcb_act_DrcQueryImport(fgw_arg_t *res, int argc, fgw_arg_t *a
 	return 0;
 }
 
+static void drc_query_explain(const char *name, const char *query)
+{
+	pcb_qry_node_t *prg;
+
+	if (query == NULL) {
+		printf("rule %s: no query string\n", name);
+		return;
+	}
+
+	prg = pcb_query_compile(query);
+	if (prg == NULL) {
+		printf("rule %s: failed to compile\n", name);
+		return;
+	}
+	pcb_qry_plan_explain(stdout, prg);
+	pcb_qry_n_free(prg);
+}
+
+static const char pcb_acts_DrcQueryExplain[] = "DrcQueryExplain([ruleID])\n";
+static const char pcb_acth_DrcQueryExplain[] = "Print the execution plan of a rule or of all rules on stdout.";
+static fgw_error_t pcb_act_DrcQueryExplain(fgw_arg_t *res, int argc, fgw_arg_t *argv)
+{
+	const char *name = NULL;
+	gdl_iterator_t it;
+	rnd_conf_listitem_t *i;
+	int found = 0;
+
+	RND_ACT_MAY_CONVARG(1, FGW_STR, DrcQueryExplain, name = argv[1].val.str);
+
+	rnd_conflist_foreach(&conf_drc_query.plugins.drc_query.rules, &it, i) {
+		lht_node_t *rule = i->prop.src;
+		if (rule->type != LHT_HASH)
+			continue;
+		if ((name != NULL) && (strcmp(i->name, name) != 0))
+			continue;
+		drc_query_explain(i->name, load_str(rule, i, "query"));
+		found++;
+	}
+
+	if ((name != NULL) && (found == 0)) {
+		rnd_message(RND_MSG_ERROR, "DrcQueryExplain: no such rule: %s\n", name);
+		RND_ACT_IRES(-1);
+		return 0;
+	}
+
+	RND_ACT_IRES(0);
+	return 0;
+}
+
 #include "dlg.c"
 
 static pcb_drc_impl_t drc_query_impl = {"drc_query", "query() based DRC", "drcquerylistrules"};
@@ -889,7 +961,8 @@ static rnd_action_t drc_query_action_list[] = {
 	{"DrcQueryRuleMod", pcb_act_DrcQueryRuleMod, pcb_acth_DrcQueryRuleMod, pcb_acts_DrcQueryRuleMod},
 	{"DrcQueryDefMod", pcb_act_DrcQueryDefMod, pcb_acth_DrcQueryDefMod, pcb_acts_DrcQueryDefMod},
 	{"DrcQueryExport", pcb_act_DrcQueryExport, pcb_acth_DrcQueryExport, pcb_acts_DrcQueryExport},
-	{"DrcQueryImport", pcb_act_DrcQueryImport, pcb_acth_DrcQueryImport, pcb_acts_DrcQueryImport}
+	{"DrcQueryImport", pcb_act_DrcQueryImport, pcb_acth_DrcQueryImport, pcb_acts_DrcQueryImport},
+	{"DrcQueryExplain", pcb_act_DrcQueryExplain, pcb_acth_DrcQueryExplain, pcb_acts_DrcQueryExplain}
 };
 
 static int drc_query_anyload_subtree(const rnd_anyload_t *al, rnd_design_t *hl, lht_node_t *root)
@@ -926,6 +999,7 @@ void pplg_uninit_drc_query(void)
 
 	rnd_remove_actions_by_cookie(drc_query_cookie);
 	pcb_drcq_stat_uninit();
+	pcb_drcq_cache_uninit();
 }
 
 static rnd_conf_hid_callbacks_t cbs;
@@ -938,8 +1012,12 @@ int pplg_init_drc_query(void)
 	RND_API_CHK_VER;
 
 	pcb_drcq_stat_init();
+	pcb_drcq_cache_init();
 
 	rnd_event_bind(PCB_EVENT_DRC_RUN, pcb_drc_query, NULL, drc_query_cookie);
+	rnd_event_bind(PCB_EVENT_BOARD_EDITED, pcb_drcq_cache_board_edited, NULL, drc_query_cookie);
+	rnd_event_bind(PCB_EVENT_UNDO_POST, pcb_drcq_cache_board_edited, NULL, drc_query_cookie);
+	rnd_event_bind(RND_EVENT_DESIGN_SET_CURRENT, pcb_drcq_cache_board_edited, NULL, drc_query_cookie);
 
 	vtp0_init(&free_drc_conf_nodes);
 	cbs.new_hlist_item_post = drc_query_newconf;
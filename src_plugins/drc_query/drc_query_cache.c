@@ -0,0 +1,156 @@
+/* Incremental DRC: remember the violations each rule produced and reuse
+   them on the next run if neither the board nor the rule (or any of the
+   definitions it uses) changed since. */
+
+typedef struct {
+	char *name;
+	char *query;            /* query script the cached violations were produced with */
+	char *type, *title, *desc; /* rule texts copied into the violations */
+	htsi_t defs;            /* definitions the query uses (by $def); key: def name */
+	pcb_board_t *pcb;
+	uundo_serial_t serial;  /* undo serial of the board when the rule was run */
+	pcb_view_list_t views;  /* private copies of the violations */
+} pcb_drcq_cache_t;
+
+static htsp_t pcb_drcq_cache;
+
+static void pcb_drcq_cache_free_fields(pcb_drcq_cache_t *c)
+{
+	htsi_entry_t *e;
+
+	pcb_view_list_free_fields(&c->views);
+	for(e = htsi_first(&c->defs); e != NULL; e = htsi_next(&c->defs, e))
+		free(e->key);
+	htsi_uninit(&c->defs);
+	free(c->query);
+	free(c->type);
+	free(c->title);
+	free(c->desc);
+}
+
+static void pcb_drcq_cache_free(pcb_drcq_cache_t *c)
+{
+	pcb_drcq_cache_free_fields(c);
+	free(c->name);
+	free(c);
+}
+
+static void pcb_drcq_cache_init(void)
+{
+	htsp_init(&pcb_drcq_cache, strhash, strkeyeq);
+}
+
+static void pcb_drcq_cache_flush(void)
+{
+	htsp_entry_t *e;
+	for(e = htsp_first(&pcb_drcq_cache); e != NULL; e = htsp_next(&pcb_drcq_cache, e))
+		pcb_drcq_cache_free(e->value);
+	htsp_clear(&pcb_drcq_cache);
+}
+
+static void pcb_drcq_cache_uninit(void)
+{
+	pcb_drcq_cache_flush();
+	htsp_uninit(&pcb_drcq_cache);
+}
+
+/* Drop the cache of rules that use definition def (by $def) */
+static void pcb_drcq_cache_drop_def(const char *def)
+{
+	htsp_entry_t *e;
+
+	for(e = htsp_first(&pcb_drcq_cache); e != NULL; e = htsp_next(&pcb_drcq_cache, e)) {
+		pcb_drcq_cache_t *c = e->value;
+		if (htsi_has(&c->defs, (char *)def)) {
+			htsp_delentry(&pcb_drcq_cache, e);
+			pcb_drcq_cache_free(c);
+		}
+	}
+}
+
+static int safe_streq(const char *s1, const char *s2)
+{
+	if ((s1 == NULL) || (s2 == NULL))
+		return s1 == s2;
+	return strcmp(s1, s2) == 0;
+}
+
+/* If the cached result of rule name is still valid, append copies of its
+   violations to dst and return the number of violations; return -1 if the
+   rule needs to be (re-)run */
+static long pcb_drcq_cache_apply(pcb_board_t *pcb, const char *name, const char *type, const char *title, const char *desc, const char *query, pcb_view_list_t *dst)
+{
+	pcb_drcq_cache_t *c;
+	pcb_view_t *v;
+	long cnt = 0;
+
+	if (!conf_drc_query.plugins.drc_query.incremental)
+		return -1;
+
+	c = htsp_get(&pcb_drcq_cache, name);
+	if ((c == NULL) || (c->pcb != pcb) || (c->serial != pcb_undo_serial()))
+		return -1;
+	if (!safe_streq(c->query, query) || !safe_streq(c->type, type) || !safe_streq(c->title, title) || !safe_streq(c->desc, desc))
+		return -1;
+
+	for(v = pcb_view_list_first(&c->views); v != NULL; v = pcb_view_list_next(v)) {
+		pcb_view_list_append(dst, pcb_view_dup(v));
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/* Save copies of the violations a rule has just produced: everything in
+   lst after last_before (or the whole list if last_before is NULL). A
+   rule's result can be reused only if all its inputs are tracked: the
+   board (by undo serial and edit events) and the definitions it uses (by
+   $def); rules reading any other config node are not cached. */
+static void pcb_drcq_cache_store(pcb_board_t *pcb, const char *name, const char *type, const char *title, const char *desc, const char *query, pcb_view_list_t *lst, pcb_view_t *last_before)
+{
+	pcb_drcq_cache_t *c;
+	pcb_view_t *v;
+	htsi_t defs;
+	htsi_entry_t *e;
+	int other_conf;
+
+	if (!conf_drc_query.plugins.drc_query.incremental)
+		return;
+
+	htsi_init(&defs, strhash, strkeyeq);
+	if ((pcb_qry_extract_conf_deps(&defs, query, &other_conf) < 0) || (other_conf > 0)) {
+		for(e = htsi_first(&defs); e != NULL; e = htsi_next(&defs, e))
+			free(e->key);
+		htsi_uninit(&defs);
+		c = htsp_pop(&pcb_drcq_cache, name);
+		if (c != NULL)
+			pcb_drcq_cache_free(c);
+		return;
+	}
+
+	c = htsp_get(&pcb_drcq_cache, name);
+	if (c == NULL) {
+		c = calloc(sizeof(pcb_drcq_cache_t), 1);
+		c->name = rnd_strdup(name);
+		htsp_set(&pcb_drcq_cache, c->name, c);
+	}
+	else
+		pcb_drcq_cache_free_fields(c);
+
+	memcpy(&c->defs, &defs, sizeof(defs));
+	c->query = rnd_strdup(query);
+	c->type = rnd_strdup(type);
+	c->title = rnd_strdup(title);
+	c->desc = rnd_strdup(desc);
+	c->pcb = pcb;
+	c->serial = pcb_undo_serial();
+
+	v = (last_before == NULL) ? pcb_view_list_first(lst) : pcb_view_list_next(last_before);
+	for(; v != NULL; v = pcb_view_list_next(v))
+		pcb_view_list_append(&c->views, pcb_view_dup(v));
+}
+
+static void pcb_drcq_cache_board_edited(rnd_design_t *hidlib, void *user_data, int argc, rnd_event_arg_t argv[])
+{
+	pcb_drcq_cache_flush();
+}
@@ -7,6 +7,7 @@ typedef struct {
 	const struct {
 		const struct {
 			RND_CFT_BOOLEAN disable;     /* disable the whole engine */
+			RND_CFT_BOOLEAN incremental; /* reuse the violations of a rule from the previous run if neither the board nor the rule or the definitions it uses changed since */
 			RND_CFT_HLIST definitions;   /* DRC constant definitions */
 			RND_CFT_HLIST rules;         /* inline rules */
 		} drc_query;
@@ -5,16 +5,31 @@
 #include <string.h>
 
 #include <librnd/core/global_typedefs.h>
+#include <genht/hash.h>
 
 #define GVT_DONT_UNDEF
 #include "aperture.h"
 #include <genvector/genvector_impl.c>
 
+/* apertures are indexed by their own (width, shape) */
+static unsigned aperture_hash(const void *key)
+{
+	const aperture_t *a = key;
+	return longhash(a->width) ^ (unsigned)a->shape;
+}
+
+static int aperture_keyeq(const void *keya, const void *keyb)
+{
+	const aperture_t *a = keya, *b = keyb;
+	return (a->width == b->width) && (a->shape == b->shape);
+}
+
 void init_aperture_list(aperture_list_t *list)
 {
 	list->data = NULL;
 	list->aperture_count_default = list->count = 0;
 	list->aperture_count = &list->aperture_count_default;
+	htpp_init(&list->index, aperture_hash, aperture_keyeq);
 }
 
 void uninit_aperture_list(aperture_list_t *list)
@@ -26,7 +41,10 @@ void uninit_aperture_list(aperture_list_t *list)
 		free(search);
 		search = next;
 	}
-	init_aperture_list(list);
+	htpp_uninit(&list->index);
+	list->data = NULL;
+	list->aperture_count_default = list->count = 0;
+	list->aperture_count = &list->aperture_count_default;
 }
 
 aperture_t *add_aperture(aperture_list_t *list, rnd_coord_t width, aperture_shape_t shape)
@@ -42,22 +60,25 @@ aperture_t *add_aperture(aperture_list_t *list, rnd_coord_t width, aperture_shap
 
 	list->data = app;
 	++list->count;
+	htpp_set(&list->index, app, app);
 
 	return app;
 }
 
 aperture_t *find_aperture(aperture_list_t *list, rnd_coord_t width, aperture_shape_t shape)
 {
-	aperture_t *search;
+	aperture_t key, *search;
 
 	/* we never draw zero-width lines */
 	if (width == 0)
 		return NULL;
 
 	/* Search for an appropriate aperture. */
-	for (search = list->data; search; search = search->next)
-		if (search->width == width && search->shape == shape)
-			return search;
+	key.width = width;
+	key.shape = shape;
+	search = htpp_get(&list->index, &key);
+	if (search != NULL)
+		return search;
 
 	/* Failing that, create a new one */
 	return add_aperture(list, width, shape);
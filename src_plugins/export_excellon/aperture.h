@@ -1,6 +1,8 @@
 #ifndef PCB_APERTURE_H
 #define PCB_APERTURE_H
 
+#include <genht/htpp.h>
+
 /*** generic aperture ***/
 
 enum aperture_shape_e {
@@ -25,9 +27,12 @@ typedef struct {
 	aperture_t *data;
 	int count;
 	int aperture_count_default, *aperture_count;
+	htpp_t index;                 /* key: (width, shape) of an aperture_t; value: (aperture_t *) from data */
 } aperture_list_t;
 
 void init_aperture_list(aperture_list_t *list);
+
+/* Free all apertures; the list needs to be init'd again before reuse */
 void uninit_aperture_list(aperture_list_t *list);
 
 /* Create and add a new aperture to the list */
@@ -151,7 +151,6 @@ static char *filesuff = NULL;
 static char *layername = NULL;
 static int lncount = 0;
 
-static int finding_apertures = 0;
 static int pagecount = 0;
 static int linewidth = -1;
 static rnd_layergrp_id_t lastgroup = -1;
@@ -159,6 +158,23 @@ static int lastcap = -1;
 static int lastcolor = -1;
 static int lastX, lastY;				/* the last X and Y coordinate */
 
+/* The drawing of a page is buffered in memory while its apertures are
+   collected; the file header with the aperture list and then the body are
+   written when the page is finished. This way the board is rendered only
+   once per export. */
+static struct {
+	int active;
+	gds_t body;
+	char *fn;                 /* file to write the page into */
+	int new_file;             /* close the previously written file first (not in cam mode) */
+	rnd_layergrp_id_t group;
+	rnd_layer_id_t layer;
+	const char *group_name;
+	int is_drill;
+	aperture_list_t *aptr_list;
+	rnd_composite_op_t drawing_mode_issued; /* as of the start of the page */
+} page;
+
 static const char *copy_outline_names[] = {
 #define COPY_OUTLINE_NONE 0
 	"none",
@@ -309,6 +325,89 @@ static void append_file_suffix(gds_t *dst, rnd_layergrp_id_t gid, rnd_layer_id_t
 	filesuff = fn_gds.array + fn_baselen;
 }
 
+/* Write the current page to the output: header, aperture list, then the
+   buffered drawing; pages that ended up without any aperture produce no
+   output (unless all layers or drill layers are requested) */
+static void gerber_flush_page(void)
+{
+	char utcTime[64];
+	aperture_list_t *aptr_list = page.aptr_list;
+	aperture_t *search;
+
+	if (!page.active)
+		return;
+	page.active = 0;
+
+	if (aptr_list->count == 0 && !all_layers && !page.is_drill) {
+		drawing_mode_issued = page.drawing_mode_issued;
+		goto done;
+	}
+
+	if (page.new_file) {
+		maybe_close_f(f);
+		f = NULL;
+	}
+
+	pagecount++;
+	if (f == NULL) { /* open a new file if we closed the previous (cam mode: only one file) */
+		f = rnd_fopen_askovr(&PCB->hidlib, page.fn, "wb", &gerber_ovr); /* Binary needed to force CR-LF */
+		if (f == NULL) {
+			rnd_message(RND_MSG_ERROR, "Error:  Could not open %s for writing.\n", page.fn);
+			goto done;
+		}
+	}
+
+	was_drill = page.is_drill;
+
+	if (verbose) {
+		int c = aptr_list->count;
+		fprintf(stderr, "Gerber: %d aperture%s in %s\n", c, c == 1 ? "" : "s", page.fn);
+	}
+
+	fprintf(f, "G04 start of page %d for group %ld layer_idx %ld *\r\n", pagecount, page.group, page.layer);
+
+	/* Create a portable timestamp. */
+	rnd_print_utc(utcTime, sizeof(utcTime), 0);
+
+	/* Print a cute file header at the beginning of each file. */
+	fprintf(f, "G04 Title: %s, %s *\r\n", RND_UNKNOWN(PCB->hidlib.name), RND_UNKNOWN(page.group_name));
+	fprintf(f, "G04 Creator: pcb-rnd " PCB_VERSION " *\r\n");
+	fprintf(f, "G04 CreationDate: %s *\r\n", utcTime);
+
+	/* ID the user. */
+	fprintf(f, "G04 For: %s *\r\n", pcb_author());
+
+	fprintf(f, "G04 Format: Gerber/RS-274X *\r\n");
+	rnd_fprintf(f, "G04 PCB-Dimensions: %[4] %[4] *\r\n", rnd_dwg_get_size_x(&PCB->hidlib), rnd_dwg_get_size_y(&PCB->hidlib));
+	fprintf(f, "G04 PCB-Coordinate-Origin: lower left *\r\n");
+
+	/* Unit and coord format */
+	fprintf(f, "%s", gerber_cfmt->hdr1);
+
+	fprintf(f, "%%LN%s*%%\r\n", layername);
+	lncount = 1;
+
+	for (search = aptr_list->data; search; search = search->next)
+		fprint_aperture(f, search);
+	if (aptr_list->count == 0) {
+		/* We need to put *something* in the file to make it be parsed
+		   as RS-274X instead of RS-274D. Need to register an aperture
+		   so aperture number is unique */
+		aperture_t *aptr = find_aperture(aptr_list, RND_MM_TO_COORD(0.0100), ROUND);
+		if (aptr == NULL)
+			aptr = add_aperture(aptr_list, RND_MM_TO_COORD(0.0100), ROUND);
+		rnd_fprintf(f, "%%ADD%dC,%[5]*%%\r\n", aptr->dCode, aptr->width);
+	}
+
+	if (page.body.used > 0)
+		fwrite(page.body.array, 1, page.body.used, f);
+
+	done:;
+	page.body.used = 0;
+	free(page.fn);
+	page.fn = NULL;
+}
+
 static void gerber_do_export(rnd_hid_t *hid, rnd_design_t *design, rnd_hid_attr_val_t *options, void *appspec)
 {
 	const char *fnbase;
@@ -384,13 +483,10 @@ static void gerber_do_export(rnd_hid_t *hid, rnd_design_t *design, rnd_hid_attr_
 
 	lastgroup = -1;
 	layer_list_idx = 0;
-	finding_apertures = 1;
-	rnd_app.expose_main(&gerber_hid, &ctx, &xform);
-
-	lastgroup = -2;
-	layer_list_idx = 0;
-	finding_apertures = 0;
+	gds_init(&page.body);
 	rnd_app.expose_main(&gerber_hid, &ctx, &xform);
+	gerber_flush_page();
+	gds_uninit(&page.body);
 
 	memcpy(pcb_layer_stack, saved_layer_stack, sizeof(pcb_layer_stack));
 
@@ -495,9 +591,7 @@ static int gerber_set_layer_group(rnd_hid_t *hid, rnd_design_t *design, rnd_laye
 	is_plated = PCB_LAYER_IS_PROUTE(flags, purpi) || PCB_LAYER_IS_PDRILL(flags, purpi);
 	is_mask = !!(flags & PCB_LYT_MASK);
 	if (group < 0 || group != lastgroup) {
-		char utcTime[64];
-		aperture_list_t *aptr_list;
-		aperture_t *search;
+		gerber_flush_page();
 
 		lastgroup = group;
 		lastX = -1;
@@ -506,56 +600,17 @@ static int gerber_set_layer_group(rnd_hid_t *hid, rnd_design_t *design, rnd_laye
 		linewidth = -1;
 		lastcap = -1;
 
-		aptr_list = set_layer_aperture_list(layer_list_idx++, want_per_file_apertures);
-
-		if (finding_apertures)
-			goto emit_outline;
-
-		if (aptr_list->count == 0 && !all_layers && !is_drill)
-			return 0;
-
-		if ((!gerber_cam.active) || (gerber_cam.fn_changed)) {
-			/* in cam mode we reuse f */
-			maybe_close_f(f);
-			f = NULL;
-		}
-
-		pagecount++;
 		append_file_suffix(&fn_gds, group, layer, flags, purpose, purpi, 0, NULL);
-		if (f == NULL) { /* open a new file if we closed the previous (cam mode: only one file) */
-			f = rnd_fopen_askovr(&PCB->hidlib, gerber_cam.active ? gerber_cam.fn : filename, "wb", &gerber_ovr); /* Binary needed to force CR-LF */
-			if (f == NULL) {
-				rnd_message(RND_MSG_ERROR, "Error:  Could not open %s for writing.\n", filename);
-				return 1;
-			}
-		}
-
-		was_drill = is_drill;
-
-		if (verbose) {
-			int c = aptr_list->count;
-			fprintf(stderr, "Gerber: %d aperture%s in %s\n", c, c == 1 ? "" : "s", filename);
-		}
-
-		fprintf(f, "G04 start of page %d for group %ld layer_idx %ld *\r\n", pagecount, group, layer);
-
-		/* Create a portable timestamp. */
-		rnd_print_utc(utcTime, sizeof(utcTime), 0);
-
-		/* Print a cute file header at the beginning of each file. */
-		fprintf(f, "G04 Title: %s, %s *\r\n", RND_UNKNOWN(PCB->hidlib.name), RND_UNKNOWN(group_name));
-		fprintf(f, "G04 Creator: pcb-rnd " PCB_VERSION " *\r\n");
-		fprintf(f, "G04 CreationDate: %s *\r\n", utcTime);
 
-		/* ID the user. */
-		fprintf(f, "G04 For: %s *\r\n", pcb_author());
-
-		fprintf(f, "G04 Format: Gerber/RS-274X *\r\n");
-		rnd_fprintf(f, "G04 PCB-Dimensions: %[4] %[4] *\r\n", rnd_dwg_get_size_x(&PCB->hidlib), rnd_dwg_get_size_y(&PCB->hidlib));
-		fprintf(f, "G04 PCB-Coordinate-Origin: lower left *\r\n");
-
-		/* Unit and coord format */
-		fprintf(f, "%s", gerber_cfmt->hdr1);
+		page.active = 1;
+		page.fn = rnd_strdup(gerber_cam.active ? gerber_cam.fn : filename);
+		page.new_file = (!gerber_cam.active) || (gerber_cam.fn_changed); /* in cam mode we reuse f */
+		page.group = group;
+		page.layer = layer;
+		page.group_name = group_name;
+		page.is_drill = is_drill;
+		page.aptr_list = set_layer_aperture_list(layer_list_idx++, want_per_file_apertures);
+		page.drawing_mode_issued = drawing_mode_issued;
 
 		/* build a legal identifier. */
 		if (layername)
@@ -570,23 +625,8 @@ static int gerber_set_layer_group(rnd_hid_t *hid, rnd_design_t *design, rnd_laye
 			else
 				*cp = '_';
 		}
-		fprintf(f, "%%LN%s*%%\r\n", layername);
-		lncount = 1;
-
-		for (search = aptr_list->data; search; search = search->next)
-			fprint_aperture(f, search);
-		if (aptr_list->count == 0) {
-			/* We need to put *something* in the file to make it be parsed
-			   as RS-274X instead of RS-274D. Need to register an aperture
-			   so aperture number is unique */
-			aperture_t *aptr = find_aperture(curr_aptr_list, RND_MM_TO_COORD(0.0100), ROUND);
-			if (aptr == NULL)
-				aptr = add_aperture(curr_aptr_list, RND_MM_TO_COORD(0.0100), ROUND);
-			rnd_fprintf(f, "%%ADD%dC,%[5]*%%\r\n", aptr->dCode, aptr->width);
-		}
 	}
 
-emit_outline:
 	/* If we're printing a copper layer other than the outline layer,
 	   and we want to "print outlines", and we have an outline layer,
 	   print the outline layer on this layer also.  */
@@ -637,8 +677,8 @@ static void gerber_destroy_gc(rnd_hid_gc_t gc)
 static void gerber_set_drawing_mode(rnd_hid_t *hid, rnd_composite_op_t op, rnd_bool direct, const rnd_box_t *drw_screen)
 {
 	gerber_drawing_mode = op;
-	if ((f != NULL) && (gerber_debug))
-		fprintf(f, "G04 hid debug composite: %d*\r\n", op);
+	if (page.active && (gerber_debug))
+		rnd_append_printf(&page.body, "G04 hid debug composite: %d*\r\n", op);
 }
 
 static void gerber_set_color(rnd_hid_gc_t gc, const rnd_color_t *color)
@@ -673,13 +713,13 @@ static void gerber_set_draw_xor(rnd_hid_gc_t gc, int xor_)
 static void use_gc(rnd_hid_gc_t gc, int radius)
 {
 	gerber_drawn_objs++;
-	if ((f != NULL) && (gerber_drawing_mode != drawing_mode_issued)) {
+	if (page.active && (gerber_drawing_mode != drawing_mode_issued)) {
 		if ((gerber_drawing_mode == RND_HID_COMP_POSITIVE) || (gerber_drawing_mode == RND_HID_COMP_POSITIVE_XOR)) {
-			fprintf(f, "%%LPD*%%\r\n");
+			gds_append_str(&page.body, "%LPD*%\r\n");
 			drawing_mode_issued = gerber_drawing_mode;
 		}
 		else if (gerber_drawing_mode == RND_HID_COMP_NEGATIVE) {
-			fprintf(f, "%%LPC*%%\r\n");
+			gds_append_str(&page.body, "%LPC*%\r\n");
 			drawing_mode_issued = gerber_drawing_mode;
 		}
 	}
@@ -690,8 +730,8 @@ static void use_gc(rnd_hid_gc_t gc, int radius)
 			aperture_t *aptr = find_aperture(curr_aptr_list, radius, ROUND);
 			if (aptr == NULL)
 				rnd_fprintf(stderr, "error: aperture for radius %$mS type ROUND is null\n", radius);
-			else if (f != NULL)
-				fprintf(f, "G54D%d*", aptr->dCode);
+			else if (page.active)
+				rnd_append_printf(&page.body, "G54D%d*", aptr->dCode);
 			linewidth = radius;
 			lastcap = rnd_cap_round;
 		}
@@ -716,8 +756,8 @@ static void use_gc(rnd_hid_gc_t gc, int radius)
 		aptr = find_aperture(curr_aptr_list, linewidth, shape);
 		if (aptr == NULL)
 			rnd_fprintf(stderr, "error: aperture for width %$mS type %s is null\n", linewidth, shape == ROUND ? "ROUND" : "SQUARE");
-		if (f && aptr)
-			fprintf(f, "G54D%d*", aptr->dCode);
+		if (page.active && aptr)
+			rnd_append_printf(&page.body, "G54D%d*", aptr->dCode);
 	}
 }
 
@@ -732,44 +772,44 @@ static void gerber_fill_polygon_offs(rnd_hid_gc_t gc, int n_coords, rnd_coord_t
 		return;
 
 	use_gc(gc, 10 * 100);
-	if (!f)
+	if (!page.active)
 		return;
-	fprintf(f, "G36*\r\n");
+	gds_append_str(&page.body, "G36*\r\n");
 	for (i = 0; i < n_coords; i++) {
 		if (x[i]+dx != lastX) {
 			m = rnd_true;
 			lastX = x[i]+dx;
-			rnd_fprintf(f, "X%[4]", gerberX(PCB, lastX));
+			rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, lastX));
 		}
 		if (y[i]+dy != lastY) {
 			m = rnd_true;
 			lastY = y[i]+dy;
-			rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+			rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 		}
 		if (firstTime) {
 			firstTime = 0;
 			startX = x[i]+dx;
 			startY = y[i]+dy;
 			if (m)
-				fprintf(f, "D02*");
+				gds_append_str(&page.body, "D02*");
 		}
 		else if (m)
-			fprintf(f, "D01*\r\n");
+			gds_append_str(&page.body, "D01*\r\n");
 		m = rnd_false;
 	}
 	if (startX != lastX) {
 		m = rnd_true;
 		lastX = startX;
-		rnd_fprintf(f, "X%[4]", gerberX(PCB, startX));
+		rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, startX));
 	}
 	if (startY != lastY) {
 		m = rnd_true;
 		lastY = startY;
-		rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+		rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 	}
 	if (m)
-		fprintf(f, "D01*\r\n");
-	fprintf(f, "G37*\r\n");
+		gds_append_str(&page.body, "D01*\r\n");
+	gds_append_str(&page.body, "G37*\r\n");
 }
 
 static void gerber_fill_polygon(rnd_hid_gc_t gc, int n_coords, rnd_coord_t *x, rnd_coord_t *y)
@@ -784,9 +824,6 @@ static void gerber_draw_line(rnd_hid_gc_t gc, rnd_coord_t x1, rnd_coord_t y1, rn
 	if (line_slots) {
 		rnd_coord_t dia = gc->width/2;
 		find_aperture(curr_aptr_list, dia*2, ROUND); /* for a real gerber export of the BOUNDARY group: place aperture on the per layer aperture list */
-
-		if (finding_apertures)
-			return;
 	}
 
 	if (x1 != x2 && y1 != y2 && gc->cap == rnd_cap_square) {
@@ -816,34 +853,34 @@ static void gerber_draw_line(rnd_hid_gc_t gc, rnd_coord_t x1, rnd_coord_t y1, rn
 	}
 
 	use_gc(gc, 0);
-	if (!f)
+	if (!page.active)
 		return;
 
 	if (x1 != lastX) {
 		m = rnd_true;
 		lastX = x1;
-		rnd_fprintf(f, "X%[4]", gerberX(PCB, lastX));
+		rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, lastX));
 	}
 	if (y1 != lastY) {
 		m = rnd_true;
 		lastY = y1;
-		rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+		rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 	}
 	if ((x1 == x2) && (y1 == y2))
-		fprintf(f, "D03*\r\n");
+		gds_append_str(&page.body, "D03*\r\n");
 	else {
 		if (m)
-			fprintf(f, "D02*");
+			gds_append_str(&page.body, "D02*");
 		if (x2 != lastX) {
 			lastX = x2;
-			rnd_fprintf(f, "X%[4]", gerberX(PCB, lastX));
+			rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, lastX));
 		}
 		if (y2 != lastY) {
 			lastY = y2;
-			rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+			rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 
 		}
-		fprintf(f, "D01*\r\n");
+		gds_append_str(&page.body, "D01*\r\n");
 	}
 }
 
@@ -865,7 +902,7 @@ static void gerber_draw_arc(rnd_hid_gc_t gc, rnd_coord_t cx, rnd_coord_t cy, rnd
 		return;
 
 	use_gc(gc, 0);
-	if (!f)
+	if (!page.active)
 		return;
 
 	/* full circle is full.... truncate so that the arc split code never needs to
@@ -938,16 +975,16 @@ static void gerber_draw_arc(rnd_hid_gc_t gc, rnd_coord_t cx, rnd_coord_t cy, rnd
 	if (arcStartX != lastX) {
 		m = rnd_true;
 		lastX = arcStartX;
-		rnd_fprintf(f, "X%[4]", gerberX(PCB, lastX));
+		rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, lastX));
 	}
 	if (arcStartY != lastY) {
 		m = rnd_true;
 		lastY = arcStartY;
-		rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+		rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 	}
 	if (m)
-		fprintf(f, "D02*");
-	rnd_fprintf(f,
+		gds_append_str(&page.body, "D02*");
+	rnd_append_printf(&page.body,
 							"G75*G0%1dX%[4]Y%[4]I%[4]J%[4]D01*G01*\r\n",
 							(delta_angle < 0) ? 2 : 3,
 							gerberX(PCB, arcStopX), gerberY(PCB, arcStopY),
@@ -963,23 +1000,19 @@ static void gerber_fill_circle(rnd_hid_gc_t gc, rnd_coord_t cx, rnd_coord_t cy,
 	if (is_drill)
 		radius = 50 * rnd_round(radius / 50.0);
 	use_gc(gc, radius);
-	if (!f)
+	if (!page.active)
 		return;
-	if (is_drill) {
-		if (finding_apertures)
-			return;
-	}
-	else if (gc->drill && !flash_drills)
+	if (!is_drill && gc->drill && !flash_drills)
 		return;
 	if (cx != lastX) {
 		lastX = cx;
-		rnd_fprintf(f, "X%[4]", gerberX(PCB, lastX));
+		rnd_append_printf(&page.body, "X%[4]", gerberX(PCB, lastX));
 	}
 	if (cy != lastY) {
 		lastY = cy;
-		rnd_fprintf(f, "Y%[4]", gerberY(PCB, lastY));
+		rnd_append_printf(&page.body, "Y%[4]", gerberY(PCB, lastY));
 	}
-	fprintf(f, "D03*\r\n");
+	gds_append_str(&page.body, "D03*\r\n");
 }
 
 static void gerber_fill_rect(rnd_hid_gc_t gc, rnd_coord_t x1, rnd_coord_t y1, rnd_coord_t x2, rnd_coord_t y2)
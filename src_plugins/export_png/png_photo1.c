@@ -30,7 +30,8 @@
 #define PHOTO_FLIP_Y 2
 
 static int photo_flip;
-static gdImagePtr photo_copper[PCB_MAX_LAYER];
+static gdImagePtr photo_copper;      /* copper of the visible side */
+static gdImagePtr photo_copper_back; /* all other copper groups merged: only used for darkening */
 static gdImagePtr photo_silk, photo_mask, photo_drill, *photo_im;
 static gdImagePtr photo_outline;
 static int photo_groups[PCB_MAX_LAYERGRP + 2], photo_ngroups;
@@ -129,6 +129,15 @@ static void subtract(rnd_drwpx_color_struct_t * dest, double a_amount, const rnd
 	clip(dest, dest);
 }
 
+static int photo_is_back_group(rnd_layergrp_id_t group)
+{
+	int lg;
+	for(lg = 1; lg < photo_ngroups; lg++)
+		if (photo_groups[lg] == group)
+			return 1;
+	return 0;
+}
+
 static int png_set_layer_group_photo(rnd_layergrp_id_t group, rnd_design_t *design, const char *purpose, int purpi, rnd_layer_id_t layer, unsigned int flags, int is_empty, rnd_xform_t **xform)
 {
 	/* workaround: the outline layer vs. alpha breaks if set twice and the draw
@@ -176,7 +185,15 @@ static int png_set_layer_group_photo(rnd_layergrp_id_t group, rnd_design_t *desi
 			photo_im = &photo_outline;
 		}
 		else if (flags & PCB_LYT_COPPER) {
-			photo_im = photo_copper + group;
+			/* the composite only checks whether there is copper on any of the
+			   groups behind the visible side, so they share a single image;
+			   copper groups not taking part in the composite are not drawn */
+			if (group == photo_groups[0])
+				photo_im = &photo_copper;
+			else if (photo_is_back_group(group))
+				photo_im = &photo_copper_back;
+			else
+				return 0;
 		}
 		else
 			return 0;
@@ -222,7 +239,7 @@ static void png_photo_head(void)
 
 static void png_photo_foot(void)
 {
-	int x, y, darken, lg;
+	int x, y, darken;
 	rnd_drwpx_color_struct_t white, black, fr4;
 
 	rgb(&white, 255, 255, 255);
@@ -231,7 +248,7 @@ static void png_photo_foot(void)
 
 	pctx->im = pctx->master_im;
 
-	ts_bs(photo_copper[photo_groups[0]]);
+	ts_bs(photo_copper);
 	if (photo_silk != NULL)
 		ts_bs(photo_silk);
 	if (photo_mask != NULL)
@@ -270,13 +287,7 @@ static void png_photo_foot(void)
 			mask = photo_mask ? gdImageGetPixel(photo_mask, x, y) : 0;
 			silk = photo_silk ? gdImageGetPixel(photo_silk, x, y) : 0;
 
-			darken = 0;
-			for(lg = 1; lg < photo_ngroups; lg++) {
-				if (photo_copper[photo_groups[lg]] && gdImageGetPixel(photo_copper[photo_groups[lg]], x, y)) {
-					darken = 1;
-					break;
-				}
-			}
+			darken = photo_copper_back ? gdImageGetPixel(photo_copper_back, x, y) : 0;
 
 			if (darken)
 				rgb(&cop, 40, 40, 40);
@@ -285,7 +296,7 @@ static void png_photo_foot(void)
 
 			blend(&cop, 0.3, &cop, &fr4);
 
-			cc = gdImageGetPixel(photo_copper[photo_groups[0]], x, y);
+			cc = gdImageGetPixel(photo_copper, x, y);
 			if (cc) {
 				int r;
 
@@ -429,7 +440,7 @@ static void png_photo_do_export(rnd_hid_attr_val_t *options)
 {
 	options[HA_mono].lng = 1;
 	options[HA_as_shown].lng = 0;
-	memset(photo_copper, 0, sizeof(photo_copper));
+	photo_copper = photo_copper_back = NULL;
 	photo_silk = photo_mask = photo_drill = 0;
 	photo_outline = 0;
 	if (options[HA_photo_flip_x].lng)
@@ -442,7 +453,6 @@ static void png_photo_do_export(rnd_hid_attr_val_t *options)
 
 static void png_photo_post_export()
 {
-	int i;
 	if (photo_silk != NULL) {
 		gdImageDestroy(photo_silk);
 		photo_silk = NULL;
@@ -459,10 +469,12 @@ static void png_photo_post_export()
 		gdImageDestroy(photo_outline);
 		photo_outline = NULL;
 	}
-	for(i = 0; i < PCB_MAX_LAYER; i++) {
-		if (photo_copper[i] != NULL) {
-			gdImageDestroy(photo_copper[i]);
-			photo_copper[i] = NULL;
-		}
+	if (photo_copper != NULL) {
+		gdImageDestroy(photo_copper);
+		photo_copper = NULL;
+	}
+	if (photo_copper_back != NULL) {
+		gdImageDestroy(photo_copper_back);
+		photo_copper_back = NULL;
 	}
 }
@@ -74,16 +74,27 @@ typedef struct {
 	char *path; /* also the key */
 	pcb_plug_fp_map_t map;
 	time_t mtime;
+	off_t size;
 	const char *fmt;
+	unsigned used:1; /* looked up in this session */
 } pcb_fp_map_cache_t;
 
 htsp_t fp_fs_cache;
 
+static struct {
+	char *fn;            /* resolved path of the index file; NULL if there's no index */
+	unsigned loaded:1;   /* load attempted (on the first library scan) */
+	unsigned dirty:1;    /* the cache has changed since it was loaded */
+} fp_fs_index;
+
 pcb_plug_fp_map_t *pcb_io_map_footprint_file_cached(rnd_design_t *hl, htsp_t *cache, struct stat *st, const char *path, const char **fmt)
 {
 	pcb_fp_map_cache_t *c;
 	c = htsp_get(cache, path);
-	if ((c != NULL) && (c->mtime >= st->st_mtime)) {
+	/* exact match: a file replaced by an older one (cp -p, tar, checkout)
+	   has a different mtime but not a newer one */
+	if ((c != NULL) && (c->mtime == st->st_mtime) && (c->size == st->st_size)) {
+		c->used = 1;
 		*fmt = c->fmt;
 		return &c->map;
 	}
@@ -98,6 +109,9 @@ pcb_plug_fp_map_t *pcb_io_map_footprint_file_cached(rnd_design_t *hl, htsp_t *ca
 
 	pcb_io_map_footprint_file(hl, path, &c->map, 1, &c->fmt);
 	c->mtime = st->st_mtime;
+	c->size = st->st_size;
+	c->used = 1;
+	fp_fs_index.dirty = 1;
 	*fmt = c->fmt;
 	return &c->map;
 }
@@ -114,6 +128,198 @@ void fp_fs_cache_uninit(htsp_t *cache)
 	htsp_uninit(cache);
 }
 
+/*** persistent map cache ***/
+
+/* The map cache is saved in a line based text file: an F line starts a
+   file entry, a P line gives its path and the optional R line the format;
+   each M line starts a map node (head first, then the footprints of a
+   library file) with an optional N name and any number of T tags. The
+   rest of the line is the value, so entries with a newline in any string
+   are not saved. The F line holds the mtime and size of the file; entries
+   are validated by exact match of both on lookup, so a stale index costs a
+   remap, never a wrong map. */
+#define FP_FS_INDEX_MAGIC "pcb-rnd-fp_fs-index-v2"
+
+static const char *fp_fs_index_fmt(const char *name)
+{
+	pcb_plug_io_t *plug;
+	for(plug = pcb_plug_io_chain; plug != NULL; plug = plug->next)
+		if ((plug->default_fmt != NULL) && (strcmp(plug->default_fmt, name) == 0))
+			return plug->default_fmt;
+	return NULL;
+}
+
+static void fp_fs_index_free(pcb_fp_map_cache_t *c)
+{
+	free(c->path);
+	pcb_io_fp_map_free(&c->map);
+	free(c);
+}
+
+/* Add a freshly loaded entry to the cache or throw it away if incomplete */
+static void fp_fs_index_commit(pcb_fp_map_cache_t *c, int bad)
+{
+	if (c == NULL)
+		return;
+	if (bad || (c->path == NULL) || (c->map.type == 0) || htsp_has(&fp_fs_cache, c->path)) {
+		fp_fs_index_free(c);
+		return;
+	}
+	htsp_set(&fp_fs_cache, c->path, c);
+}
+
+static void fp_fs_index_load(void)
+{
+	FILE *f;
+	char line[8192], *val, *end;
+	pcb_fp_map_cache_t *c = NULL;
+	pcb_plug_fp_map_t *m = NULL;
+	int bad = 0;
+	const char *conf_fn = conf_fp_fs.plugins.fp_fs.index_file;
+
+	fp_fs_index.loaded = 1;
+	if ((conf_fn == NULL) || (*conf_fn == '\0'))
+		return;
+	fp_fs_index.fn = rnd_build_fn(NULL, conf_fn);
+	if (fp_fs_index.fn == NULL)
+		return;
+
+	f = rnd_fopen(NULL, fp_fs_index.fn, "r");
+	if (f == NULL)
+		return;
+
+	if ((fgets(line, sizeof(line), f) == NULL) || (strncmp(line, FP_FS_INDEX_MAGIC "\n", strlen(FP_FS_INDEX_MAGIC)+1) != 0)) {
+		fclose(f);
+		return;
+	}
+
+	while(fgets(line, sizeof(line), f) != NULL) {
+		end = strchr(line, '\n');
+		if (end == NULL) /* too long or truncated: the rest of the file can not be trusted */
+			break;
+		*end = '\0';
+		if ((line[0] == '\0') || (line[1] != ' '))
+			continue;
+		val = line+2;
+
+		if (line[0] == 'F') {
+			fp_fs_index_commit(c, bad);
+			c = calloc(sizeof(pcb_fp_map_cache_t), 1);
+			c->mtime = strtol(val, &end, 10);
+			c->size = strtol(end, NULL, 10);
+			m = NULL;
+			bad = 0;
+			continue;
+		}
+		if (c == NULL)
+			continue;
+
+		switch(line[0]) {
+			case 'P':
+				free(c->path);
+				c->path = rnd_strdup(val);
+				break;
+			case 'R':
+				c->fmt = fp_fs_index_fmt(val);
+				if (c->fmt == NULL) /* the io plugin is not available anymore */
+					bad = 1;
+				break;
+			case 'M':
+				if (m == NULL)
+					m = &c->map;
+				else {
+					m->next = calloc(sizeof(pcb_plug_fp_map_t), 1);
+					m = m->next;
+				}
+				m->type = strtol(val, &end, 10);
+				m->libtype = strtol(end, NULL, 10);
+				break;
+			case 'N':
+				if (m != NULL) {
+					free(m->name);
+					m->name = rnd_strdup(val);
+				}
+				break;
+			case 'T':
+				if (m != NULL)
+					vts0_append(&m->tags, (char *)pcb_fp_tag(val, 1));
+				break;
+		}
+	}
+	fp_fs_index_commit(c, bad);
+	fclose(f);
+}
+
+static int fp_fs_index_savable(const char *s)
+{
+	return (s == NULL) || (strpbrk(s, "\r\n") == NULL);
+}
+
+static void fp_fs_index_save(void)
+{
+	htsp_entry_t *e;
+	char *tmpfn;
+	FILE *f;
+
+	if ((fp_fs_index.fn == NULL) || !fp_fs_index.dirty)
+		return;
+
+	tmpfn = rnd_concat(fp_fs_index.fn, ".tmp", NULL);
+	f = rnd_fopen(NULL, tmpfn, "w");
+	if (f == NULL) {
+		free(tmpfn);
+		return;
+	}
+
+	fprintf(f, "%s\n", FP_FS_INDEX_MAGIC);
+	for(e = htsp_first(&fp_fs_cache); e != NULL; e = htsp_next(&fp_fs_cache, e)) {
+		pcb_fp_map_cache_t *c = e->value;
+		pcb_plug_fp_map_t *m;
+		long n;
+
+		/* do not keep files that were not seen in this session: they may be
+		   removed or belong to a library not used anymore */
+		if (!c->used || !fp_fs_index_savable(c->path))
+			continue;
+		for(m = &c->map; m != NULL; m = m->next) {
+			if (!fp_fs_index_savable(m->name))
+				break;
+			for(n = 0; n < m->tags.used; n++)
+				if (!fp_fs_index_savable(m->tags.array[n]))
+					break;
+			if (n < m->tags.used)
+				break;
+		}
+		if (m != NULL)
+			continue;
+
+		fprintf(f, "F %ld %ld\nP %s\n", (long)c->mtime, (long)c->size, c->path);
+		if (c->fmt != NULL)
+			fprintf(f, "R %s\n", c->fmt);
+		for(m = &c->map; m != NULL; m = m->next) {
+			fprintf(f, "M %d %d\n", (int)m->type, (int)m->libtype);
+			if (m->name != NULL)
+				fprintf(f, "N %s\n", m->name);
+			for(n = 0; n < m->tags.used; n++)
+				fprintf(f, "T %s\n", m->tags.array[n]);
+		}
+	}
+	fclose(f);
+
+	if (rnd_rename(NULL, tmpfn, fp_fs_index.fn) != 0)
+		rnd_unlink(NULL, tmpfn);
+	free(tmpfn);
+	fp_fs_index.dirty = 0;
+}
+
+static void fp_fs_index_uninit(void)
+{
+	fp_fs_index_save();
+	free(fp_fs_index.fn);
+	fp_fs_index.fn = NULL;
+	fp_fs_index.loaded = 0;
+}
+
 
 /*** list and search ***/
 
@@ -125,6 +331,7 @@ struct list_dir_s {
 	char *subdir;
 	pcb_plug_fp_map_t *children;
 	const char *fmt;
+	int is_file;   /* a library file with multiple footprints (virtual dir) */
 	list_dir_t *next;
 };
 
@@ -151,6 +358,7 @@ static int list_cb(void *cookie, const char *subdir, const char *name, pcb_fptyp
 		d->next = l->subdirs;
 		d->children = children;
 		d->fmt = fmt;
+		d->is_file = (type == PCB_FP_FILEDIR);
 		l->subdirs = d;
 		return 0;
 	}
@@ -315,10 +523,45 @@ static int fp_fs_list(pcb_fplibrary_t *pl, const char *subdir, int recurse,
 	return n_footprints;
 }
 
-static int fp_fs_load_dir_(pcb_fplibrary_t *pl, const char *subdir, const char *toppath, int is_root, pcb_plug_fp_map_t *children, const char *parent_fmt, int recdepth)
+static int fp_fs_load_dir_(pcb_fplibrary_t *pl, const char *subdir, const char *toppath, int is_root, pcb_plug_fp_map_t *children, const char *parent_fmt, int recdepth);
+
+/* Map the files of the directory working into menu. Virtual dirs (library
+   files) are loaded right away from their map; real subdirectories are
+   created lazy, to be loaded by fp_fs_load_subdir() on first access. */
+static int fp_fs_load_into(pcb_fplibrary_t *menu, const char *working, int is_root, int recdepth)
 {
 	list_st_t l;
 	list_dir_t *d, *nextd;
+
+	l.menu = menu;
+	l.subdirs = NULL;
+	l.children = 0;
+	l.is_virtual_dir = 0;
+
+	fp_fs_list(l.menu, working, 0, list_cb, &l, is_root, 1, recdepth);
+
+	/* now process each subdirectory mapped in the previous call;
+	   by now we don't care if menu is ruined by the realloc() in pcb_lib_menu_new() */
+	for (d = l.subdirs; d != NULL; d = nextd) {
+		if (d->is_file) {
+			l.children += fp_fs_load_dir_(l.menu, d->subdir, d->parent, 0, d->children, d->fmt, recdepth+1);
+		}
+		else {
+			pcb_fplibrary_t *sub = pcb_fp_mkdir_len(l.menu, d->subdir, -1);
+			sub->data.dir.lazy = rnd_concat(d->parent, RND_DIR_SEPARATOR_S, d->subdir, NULL);
+			l.children++; /* unknown content; count the dir so the parent is kept */
+		}
+		nextd = d->next;
+		free(d->subdir);
+		free(d->parent);
+		free(d);
+	}
+	return l.children;
+}
+
+static int fp_fs_load_dir_(pcb_fplibrary_t *pl, const char *subdir, const char *toppath, int is_root, pcb_plug_fp_map_t *children, const char *parent_fmt, int recdepth)
+{
+	list_st_t l;
 	char working_[RND_PATH_MAX + 1];
 	const char *visible_subdir;
 	char *working;  /* String holding abs path to working dir */
@@ -355,17 +598,7 @@ static int fp_fs_load_dir_(pcb_fplibrary_t *pl, const char *subdir, const char *
 		return l.children;
 	}
 
-	fp_fs_list(l.menu, working, 0, list_cb, &l, is_root, 1, recdepth);
-
-	/* now recurse to each subdirectory mapped in the previous call;
-	   by now we don't care if menu is ruined by the realloc() in pcb_lib_menu_new() */
-	for (d = l.subdirs; d != NULL; d = nextd) {
-		l.children += fp_fs_load_dir_(l.menu, d->subdir, d->parent, 0, d->children, d->fmt, recdepth+1);
-		nextd = d->next;
-		free(d->subdir);
-		free(d->parent);
-		free(d);
-	}
+	l.children = fp_fs_load_into(l.menu, working, is_root, recdepth);
 	if ((l.children == 0) && (l.menu->data.dir.children.used == 0))
 		pcb_fp_rmdir(l.menu);
 	free(working);
@@ -377,6 +610,9 @@ static int fp_fs_load_dir(pcb_plug_fp_t *ctx, const char *path, int force)
 {
 	int res;
 
+	if (!fp_fs_index.loaded)
+		fp_fs_index_load();
+
 	res = fp_fs_load_dir_(&pcb_library, ".", path, 1, NULL, NULL, 0);
 	if (res >= 0) {
 		pcb_fplibrary_t *l = pcb_fp_lib_search(&pcb_library, path);
@@ -386,6 +622,21 @@ static int fp_fs_load_dir(pcb_plug_fp_t *ctx, const char *path, int force)
 	return res;
 }
 
+/* Load a dir fp_fs_load_into() left lazy; an empty dir stays in the tree
+   because the caller may hold a pointer to it */
+static int fp_fs_load_subdir(pcb_plug_fp_t *ctx, pcb_fplibrary_t *dir, const char *loc)
+{
+	int depth = 0;
+	pcb_fplibrary_t *p;
+
+	/* same numbering as the eager load: the library root directory of the
+	   backend (child of pcb_library) is at depth 0 */
+	for(p = dir; (p->parent != NULL) && (p->parent->parent != NULL); p = p->parent)
+		depth++;
+
+	return fp_fs_load_into(dir, loc, 0, depth);
+}
+
 typedef struct {
 	const char *target;
 	int target_len;
@@ -594,6 +845,7 @@ void pplg_uninit_fp_fs(void)
 
 	rnd_conf_hid_unreg(fp_fs_cookie);
 
+	fp_fs_index_uninit();
 	fp_fs_cache_uninit(&fp_fs_cache);
 	rnd_conf_plug_unreg("plugins/fp_fs/", fp_fs_conf_internal, fp_fs_cookie);
 	fp_fs_free_remove_regex();
@@ -606,6 +858,7 @@ int pplg_init_fp_fs(void)
 	RND_API_CHK_VER;
 	fp_fs.plugin_data = NULL;
 	fp_fs.load_dir = fp_fs_load_dir;
+	fp_fs.load_subdir = fp_fs_load_subdir;
 	fp_fs.fp_fopen = fp_fs_fopen;
 	fp_fs.fp_fclose = fp_fs_fclose;
 	RND_HOOK_REGISTER(pcb_plug_fp_t, pcb_plug_fp_chain, &fp_fs);
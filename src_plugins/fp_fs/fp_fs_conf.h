@@ -9,6 +9,7 @@ typedef struct {
 			RND_CFT_LIST ignore_prefix; /* ignore file names starting with these prefixes */
 			RND_CFT_LIST ignore_suffix; /* ignore file names ending with these suffixes */
 			RND_CFT_LIST remove_regex;  /* regex's used to remove 'file extension', e.g. .fp or .lht to match footprint file name to footprint sch name */
+			RND_CFT_STRING index_file;  /* footprint file map cache saved on exit and loaded on the first library scan so unchanged files are not opened again on startup; empty means no index */
 		} fp_fs;
 	} plugins;
 } conf_fp_fs_t;
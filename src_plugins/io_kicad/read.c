@@ -2796,8 +2796,10 @@ int io_kicad_read_pcb(pcb_plug_io_t *ctx, pcb_board_t *Ptr, const char *Filename
 	   PCB (loading the default PCB), because we won't get a font from KiCad. */
 	st.pcb->fontkit.valid = rnd_true;
 
-	if (clipi)
+	if (clipi) {
+		pcb_data_rtree_repack(st.pcb->Data);
 		pcb_data_clip_inhibit_dec(st.pcb->Data, rnd_true);
+	}
 
 
 	return readres;
@@ -29,11 +29,13 @@
 #include "plug_io.h"
 #include "read.h"
 #include "write.h"
+#include "snapshot.h"
 #include "io_lihata.h"
 
 pcb_plug_io_t plug_io_lihata_v1, plug_io_lihata_v2, plug_io_lihata_v3,
               plug_io_lihata_v4, plug_io_lihata_v5, plug_io_lihata_v6,
-              plug_io_lihata_v7, plug_io_lihata_v8, plug_io_lihata_v9;
+              plug_io_lihata_v7, plug_io_lihata_v8, plug_io_lihata_v9,
+              plug_io_lihata_snapshot;
 conf_io_lihata_t conf_io_lihata;
 
 pcb_plug_io_t *plug_io_lihata_default = &plug_io_lihata_v9;
@@ -72,6 +74,7 @@ int pplg_check_ver_io_lihata(int ver_needed) { return 0; }
 void pplg_uninit_io_lihata(void)
 {
 	rnd_conf_unreg_fields("plugins/io_lihata/");
+	RND_HOOK_UNREGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_snapshot);
 	RND_HOOK_UNREGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_v9);
 	RND_HOOK_UNREGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_v8);
 	RND_HOOK_UNREGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_v7);
@@ -170,6 +173,18 @@ int pplg_init_io_lihata(void)
 	plug_io_lihata_v1.save_preference_prio = 100;
 	RND_HOOK_REGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_v1);
 
+	plug_io_lihata_snapshot.plugin_data = NULL;
+	plug_io_lihata_snapshot.fmt_support_prio = io_lihata_snapshot_fmt;
+	plug_io_lihata_snapshot.test_parse = io_lihata_snapshot_test_parse;
+	plug_io_lihata_snapshot.parse_pcb = io_lihata_snapshot_parse_pcb;
+	plug_io_lihata_snapshot.write_pcb = io_lihata_snapshot_write_pcb;
+	plug_io_lihata_snapshot.default_fmt = "lhtsnap";
+	plug_io_lihata_snapshot.description = "binary lihata board snapshot";
+	plug_io_lihata_snapshot.save_preference_prio = 20;
+	plug_io_lihata_snapshot.default_extension = ".lhtsnap";
+	plug_io_lihata_snapshot.mime_type = "application/x-pcbrnd-board-snapshot";
+	RND_HOOK_REGISTER(pcb_plug_io_t, pcb_plug_io_chain, &plug_io_lihata_snapshot);
+
 #define conf_reg(field,isarray,type_name,cpath,cname,desc,flags) \
 	rnd_conf_reg_field(conf_io_lihata, field,isarray,type_name,cpath,cname,desc,flags);
 #include "lht_conf_fields.h"
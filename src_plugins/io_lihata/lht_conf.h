@@ -11,6 +11,7 @@ typedef struct {
 			RND_CFT_BOOLEAN omit_config;     /* [dangerous] do not save the config subtree in board files */
 			RND_CFT_BOOLEAN omit_styles;     /* do not save the routing styles subtree in board files */
 			RND_CFT_BOOLEAN denoise;         /* do not save rats, select/found/warn flags to reduce VCS diff noise */
+			RND_CFT_BOOLEAN fast_save;       /* normal (user requested) saves only: write boards in the canonical form, without preserving the formatting of the file being overwritten; saves the lhtpers merge on large boards, but reformats hand edited files; backups and emergency saves are always written in the canonical form */
 		} io_lihata;
 	} plugins;
 } conf_io_lihata_t;
@@ -658,6 +658,19 @@ static int parse_thermal_heavy(lht_read_t *rctx, pcb_any_obj_t *obj, lht_node_t
 	return 0;
 }
 
+/* Once an object is built from its subtree, the subtree is not needed and
+   is removed from the document. This way the memory of the DOM is reused
+   for the board as the load progresses, instead of holding both in full.
+   The subtree is kept if a thermal node of it got saved for post-processing
+   (th_old and th_heavy are the length of the post lists before the object
+   got parsed). */
+static void obj_node_release(lht_read_t *rctx, lht_node_t *obj, long th_old, long th_heavy)
+{
+	if ((vtp0_len(&rctx->post_thermal_old) != th_old) || (vtp0_len(&rctx->post_thermal_heavy) != th_heavy))
+		return;
+	lht_tree_del(obj);
+}
+
 static int parse_line(lht_read_t *rctx, pcb_layer_t *ly, lht_node_t *obj, rnd_coord_t dx, rnd_coord_t dy)
 {
 	pcb_line_t *line;
@@ -1218,7 +1231,7 @@ static pcb_layer_combining_t parse_comb(pcb_board_t *pcb, lht_node_t *ncmb)
 
 static int parse_data_layer(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt, lht_node_t *grp, int layer_id, int bound, pcb_data_t *subc_parent)
 {
-	lht_node_t *n, *lst, *ncmb, *nvis, *npurp;
+	lht_node_t *n, *next, *lst, *ncmb, *nvis, *npurp;
 	lht_dom_iterator_t it;
 	pcb_layer_t *ly = &dt->Layer[layer_id];
 
@@ -1310,7 +1323,10 @@ static int parse_data_layer(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt,
 		if (lst->type != LHT_LIST)
 			return iolht_error(lst, "objects must be in a list\n");
 
-		for(n = lht_dom_first(&it, lst); n != NULL; n = lht_dom_next(&it)) {
+		for(n = lht_dom_first(&it, lst); n != NULL; n = next) {
+			long th_old = vtp0_len(&rctx->post_thermal_old), th_heavy = vtp0_len(&rctx->post_thermal_heavy);
+
+			next = lht_dom_next(&it);
 			if (strncmp(n->name, "line.", 5) == 0)
 				parse_line(rctx, ly, n, 0, 0);
 			if (strncmp(n->name, "arc.", 4) == 0)
@@ -1321,6 +1337,7 @@ static int parse_data_layer(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt,
 				parse_polygon(rctx, ly, n);
 			if (strncmp(n->name, "text.", 5) == 0)
 				parse_pcb_text(rctx, ly, n);
+			obj_node_release(rctx, n, th_old, th_heavy);
 		}
 	}
 
@@ -1624,7 +1641,8 @@ static int parse_subc(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt, lht_no
 {
 	pcb_subc_t *sc = pcb_subc_alloc();
 	unsigned char intconn = 0;
-	int n;
+	int n, inhibit;
+	pcb_data_t *res;
 
 	if (obj->type != LHT_HASH)
 		return iolht_error(obj, "subc.ID must be a hash\n");
@@ -1642,7 +1660,20 @@ static int parse_subc(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt, lht_no
 	pcb_subc_reg(dt, sc);
 	pcb_obj_id_reg(dt, sc);
 
-	if (parse_data(rctx, pcb, sc->data, lht_dom_hash_get(obj, "data"), dt) == 0)
+	/* when the parent is loaded with poly clipping inhibited, polygons of the
+	   subcircuit are only marked dirty too: clipping them against a half
+	   loaded board would be wasted, they are clipped again when the parent's
+	   inhibit is released (that recurses into subcircuits) */
+	inhibit = (dt->clip_inhibit > 0);
+	if (inhibit)
+		pcb_data_clip_inhibit_inc(sc->data);
+
+	res = parse_data(rctx, pcb, sc->data, lht_dom_hash_get(obj, "data"), dt);
+
+	if (inhibit)
+		sc->data->clip_inhibit--;
+
+	if (res == 0)
 		return iolht_error(obj, "Invalid subc: no data\n");
 
 	for(n = 0; n < sc->data->LayerN; n++)
@@ -1664,13 +1695,16 @@ static int parse_subc(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *dt, lht_no
 
 static int parse_data_objects(lht_read_t *rctx, pcb_board_t *pcb_for_font, pcb_data_t *dt, lht_node_t *grp)
 {
-	lht_node_t *n;
+	lht_node_t *n, *next;
 	lht_dom_iterator_t it;
 
 	if (grp->type != LHT_LIST)
 		return iolht_error(grp, "groups must be a list\n");
 
-	for(n = lht_dom_first(&it, grp); n != NULL; n = lht_dom_next(&it)) {
+	for(n = lht_dom_first(&it, grp); n != NULL; n = next) {
+		long th_old = vtp0_len(&rctx->post_thermal_old), th_heavy = vtp0_len(&rctx->post_thermal_heavy);
+
+		next = lht_dom_next(&it);
 		if (strncmp(n->name, "padstack_ref.", 13) == 0)
 			parse_pstk(rctx, dt, n);
 		if (strncmp(n->name, "via.", 4) == 0)
@@ -1682,6 +1716,7 @@ static int parse_data_objects(lht_read_t *rctx, pcb_board_t *pcb_for_font, pcb_d
 		else if (strncmp(n->name, "subc.", 5) == 0)
 			if (parse_subc(rctx, pcb_for_font, dt, n, NULL) != 0)
 				return iolht_error(n, "failed to parse subcircuit\n");
+		obj_node_release(rctx, n, th_old, th_heavy);
 	}
 
 	return 0;
@@ -2173,7 +2208,7 @@ static pcb_data_t *parse_data(lht_read_t *rctx, pcb_board_t *pcb, pcb_data_t *ds
 	if (rctx->rdver == 1)
 		layer_fixup(pcb);
 
-	if ((rctx->rdver < 6) && (pcb != NULL))
+	if ((rctx->rdver < 6) && (pcb != NULL) && !bound_layers) /* board layers only, not once per subcircuit */
 		outline_fixup(pcb);
 
 	if (rctx->rdver >= 4) {
@@ -2618,6 +2653,8 @@ static int parse_board(lht_read_t *rctx, pcb_board_t *pcb, lht_node_t *nd)
 		goto error;
 	}
 
+	pcb_data_rtree_repack(pcb->Data);
+
 	/* Run poly clipping at the end so we have all IDs and we can
 	   announce the clipping (it's slow, we may need a progress bar) */
 	{
@@ -2721,6 +2758,18 @@ int io_lihata_parse_pcb(pcb_plug_io_t *ctx, pcb_board_t *Ptr, const char *Filena
 	return res;
 }
 
+int io_lihata_parse_board_doc(pcb_board_t *pcb, lht_doc_t *doc, rnd_conf_role_t settings_dest)
+{
+	lht_read_t rctx = {0};
+
+	rctx.cfg_dest = settings_dest;
+
+	if ((doc->root->type != LHT_HASH) || (strncmp(doc->root->name, "pcb-rnd-board-v", 15) != 0))
+		return iolht_error(doc->root, "not a board\n");
+
+	return parse_board(&rctx, pcb, doc->root);
+}
+
 int io_lihata_parse_buffer(pcb_plug_io_t *ctx, pcb_buffer_t *buff, const char *filename)
 {
 	int res;
@@ -24,6 +24,7 @@
  *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
  */
 
+#include <liblihata/dom.h>
 #include "plug_io.h"
 
 int io_lihata_test_parse(pcb_plug_io_t *ctx, pcb_plug_iot_t typ, const char *Filename, FILE *f);
@@ -34,4 +35,7 @@ int io_lihata_parse_padstack(pcb_plug_io_t *ctx, pcb_pstk_proto_t *proto, const
 int io_lihata_parse_buffer(pcb_plug_io_t *ctx, pcb_buffer_t *buff, const char *filename);
 pcb_plug_fp_map_t *io_lihata_map_footprint(pcb_plug_io_t *ctx, FILE *f, const char *fn, pcb_plug_fp_map_t *head, int need_tags);
 
-
+/* Load a board from an already parsed lihata document; same as
+   io_lihata_parse_pcb() without the file I/O, but accepts boards only.
+   The document is partially consumed. */
+int io_lihata_parse_board_doc(pcb_board_t *pcb, lht_doc_t *doc, rnd_conf_role_t settings_dest);
@@ -0,0 +1,431 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  pcb-rnd, interactive printed circuit board design
+ *  Copyright (C) 2024 Tibor 'Igor2' Palinkas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  Contact:
+ *    Project page: http://repo.hu/projects/pcb-rnd
+ *    lead developer: http://repo.hu/projects/pcb-rnd/contact.html
+ *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
+ */
+
+/* Binary board snapshot: the very same document the lihata board writer
+   builds, serialized as a compact binary tree instead of lihata text. The
+   loader decodes the tree straight into a lihata DOM, without lexing,
+   unescaping or keeping track of text positions, then runs the normal
+   lihata board parser on it. Thus every board feature lihata has is
+   supported and a board loaded from a snapshot is the same as the board
+   loaded from the lihata file the snapshot was saved from. Meant for
+   batch processing that reloads the same board many times; there's no
+   attempt to preserve any formatting, the file is not meant to be edited.
+
+   File format; numbers are unsigned varints (7 bits per byte, least
+   significant group first, high bit set on all but the last byte):
+     magic        SNAP_MAGIC
+     node         the root node, recursively
+     end          a single SNAP_END byte
+
+   node:
+     type         a single byte: SNAP_TEXT, SNAP_LIST, SNAP_HASH or SNAP_TABLE
+     name         0 for no name; 1 for a new name, followed by a string,
+                  which is appended to the name table; n >= 2 refers to
+                  name table entry n-2
+     payload      text: 0 for NULL, else 1 followed by a string
+                  list and hash: number of children then the children
+                  table: number of rows and columns then rows*cols nodes, row major
+
+   string: number of bytes, the bytes, then a '\0'
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <genht/htsi.h>
+#include <genht/hash.h>
+#include <genvector/vtp0.h>
+#include <liblihata/tree.h>
+#include "board.h"
+#include "data.h"
+#include "plug_io.h"
+#include <librnd/core/error.h>
+#include <librnd/core/compat_misc.h>
+#include <librnd/core/safe_fs.h>
+#include "read.h"
+#include "write.h"
+#include "snapshot.h"
+
+#define SNAP_MAGIC "pcb-rnd-lhtsnap-v1\n"
+#define SNAP_MAGIC_LEN (sizeof(SNAP_MAGIC)-1)
+#define SNAP_LHT_VER 9 /* lihata board version of the document stored */
+#define SNAP_MAX_DEPTH 256
+
+enum {
+	SNAP_TEXT = 't',
+	SNAP_LIST = 'l',
+	SNAP_HASH = 'h',
+	SNAP_TABLE = 'T',
+	SNAP_END = 'E'
+};
+
+int io_lihata_snapshot_fmt(pcb_plug_io_t *ctx, pcb_plug_iot_t typ, int wr, const char *fmt)
+{
+	if (strcmp(ctx->description, fmt) == 0)
+		return 200;
+
+	if ((strcmp(fmt, ctx->default_fmt) != 0) || ((typ & (~PCB_IOT_PCB)) != 0))
+		return 0;
+
+	return 100;
+}
+
+int io_lihata_snapshot_test_parse(pcb_plug_io_t *ctx, pcb_plug_iot_t typ, const char *Filename, FILE *f)
+{
+	char buf[SNAP_MAGIC_LEN];
+
+	if ((typ & (~PCB_IOT_PCB)) != 0)
+		return 0;
+
+	if (fread(buf, 1, SNAP_MAGIC_LEN, f) != SNAP_MAGIC_LEN)
+		return 0;
+
+	return memcmp(buf, SNAP_MAGIC, SNAP_MAGIC_LEN) == 0;
+}
+
+/*** write ***/
+
+typedef struct {
+	FILE *f;
+	htsi_t names;   /* key: node name (not allocated, points into the doc); value: name table index */
+	int next_name;
+} snap_write_t;
+
+static void snap_put_num(FILE *f, unsigned long n)
+{
+	while(n >= 0x80) {
+		fputc((n & 0x7F) | 0x80, f);
+		n >>= 7;
+	}
+	fputc(n, f);
+}
+
+static void snap_put_str(FILE *f, const char *s)
+{
+	size_t len = strlen(s);
+	snap_put_num(f, len);
+	fwrite(s, 1, len+1, f);
+}
+
+static void snap_put_name(snap_write_t *wctx, const char *name)
+{
+	htsi_entry_t *e;
+
+	if (name == NULL) {
+		snap_put_num(wctx->f, 0);
+		return;
+	}
+
+	e = htsi_getentry(&wctx->names, (char *)name);
+	if (e != NULL) {
+		snap_put_num(wctx->f, e->value + 2);
+		return;
+	}
+
+	htsi_set(&wctx->names, (char *)name, wctx->next_name++);
+	snap_put_num(wctx->f, 1);
+	snap_put_str(wctx->f, name);
+}
+
+static int snap_put_node(snap_write_t *wctx, lht_node_t *nd)
+{
+	lht_dom_iterator_t it;
+	lht_node_t *n;
+	unsigned long cnt;
+	int r, c;
+
+	switch(nd->type) {
+		case LHT_TEXT:
+			fputc(SNAP_TEXT, wctx->f);
+			snap_put_name(wctx, nd->name);
+			if (nd->data.text.value != NULL) {
+				snap_put_num(wctx->f, 1);
+				snap_put_str(wctx->f, nd->data.text.value);
+			}
+			else
+				snap_put_num(wctx->f, 0);
+			return 0;
+
+		case LHT_LIST:
+		case LHT_HASH:
+			fputc((nd->type == LHT_LIST ? SNAP_LIST : SNAP_HASH), wctx->f);
+			snap_put_name(wctx, nd->name);
+			for(n = lht_dom_first(&it, nd), cnt = 0; n != NULL; n = lht_dom_next(&it))
+				cnt++;
+			snap_put_num(wctx->f, cnt);
+			for(n = lht_dom_first(&it, nd); n != NULL; n = lht_dom_next(&it))
+				if (snap_put_node(wctx, n) != 0)
+					return -1;
+			return 0;
+
+		case LHT_TABLE:
+			fputc(SNAP_TABLE, wctx->f);
+			snap_put_name(wctx, nd->name);
+			snap_put_num(wctx->f, nd->data.table.rows);
+			snap_put_num(wctx->f, nd->data.table.cols);
+			for(r = 0; r < nd->data.table.rows; r++)
+				for(c = 0; c < nd->data.table.cols; c++)
+					if (snap_put_node(wctx, nd->data.table.r[r][c]) != 0)
+						return -1;
+			return 0;
+
+		default:
+			rnd_message(RND_MSG_ERROR, "io_lihata snapshot: can't save node '%s': unsupported node type %d\n", nd->name, nd->type);
+			return -1;
+	}
+}
+
+int io_lihata_snapshot_write_pcb(pcb_plug_io_t *ctx, FILE *f, const char *old_filename, const char *new_filename, rnd_bool emergency)
+{
+	snap_write_t wctx;
+	lht_doc_t *brd;
+	int res;
+
+	brd = io_lihata_build_board_doc(PCB, SNAP_LHT_VER);
+	if (brd == NULL) {
+		rnd_message(RND_MSG_ERROR, "Failed to build the board for the snapshot - nothing is written\n");
+		return -1;
+	}
+
+	wctx.f = f;
+	wctx.next_name = 0;
+	htsi_init(&wctx.names, strhash, strkeyeq);
+
+	fwrite(SNAP_MAGIC, 1, SNAP_MAGIC_LEN, f);
+	res = snap_put_node(&wctx, brd->root);
+	if (res == 0)
+		fputc(SNAP_END, f);
+	if (ferror(f))
+		res = -1;
+
+	htsi_uninit(&wctx.names);
+	lht_dom_uninit(brd);
+	return res;
+}
+
+/*** read ***/
+
+typedef struct {
+	const unsigned char *p, *end;
+	lht_doc_t *doc;
+	vtp0_t names;   /* of (const char *), pointing into the file image */
+} snap_read_t;
+
+static int snap_get_num(snap_read_t *rctx, unsigned long *res)
+{
+	unsigned long n = 0;
+	int shift = 0;
+
+	for(;;) {
+		if ((rctx->p >= rctx->end) || (shift >= (int)(sizeof(unsigned long) * 8)))
+			return -1;
+		n |= (unsigned long)(*rctx->p & 0x7F) << shift;
+		if ((*rctx->p++ & 0x80) == 0)
+			break;
+		shift += 7;
+	}
+
+	*res = n;
+	return 0;
+}
+
+/* Returns a pointer into the file image; the string is '\0' terminated there */
+static const char *snap_get_str(snap_read_t *rctx)
+{
+	unsigned long len;
+	const char *s;
+
+	if (snap_get_num(rctx, &len) != 0)
+		return NULL;
+	if ((len >= (unsigned long)(rctx->end - rctx->p)) || (rctx->p[len] != '\0'))
+		return NULL;
+
+	s = (const char *)rctx->p;
+	rctx->p += len+1;
+	return s;
+}
+
+static int snap_get_name(snap_read_t *rctx, const char **name)
+{
+	unsigned long n;
+
+	if (snap_get_num(rctx, &n) != 0)
+		return -1;
+
+	switch(n) {
+		case 0:
+			*name = NULL;
+			return 0;
+		case 1:
+			*name = snap_get_str(rctx);
+			if (*name == NULL)
+				return -1;
+			vtp0_append(&rctx->names, (void *)*name);
+			return 0;
+	}
+
+	if (n-2 >= rctx->names.used)
+		return -1;
+	*name = rctx->names.array[n-2];
+	return 0;
+}
+
+static lht_node_t *snap_get_node(snap_read_t *rctx, int depth)
+{
+	lht_node_t *nd, *ch;
+	const char *name, *val;
+	unsigned long n, cnt, rows, cols, r, c;
+	int type;
+
+	if ((rctx->p >= rctx->end) || (depth > SNAP_MAX_DEPTH))
+		return NULL;
+
+	type = *rctx->p++;
+	if (snap_get_name(rctx, &name) != 0)
+		return NULL;
+
+	switch(type) {
+		case SNAP_TEXT:
+			if (snap_get_num(rctx, &n) != 0)
+				return NULL;
+			nd = lht_dom_node_alloc(LHT_TEXT, name);
+			nd->doc = rctx->doc;
+			if (n != 0) {
+				val = snap_get_str(rctx);
+				if (val == NULL)
+					goto error;
+				nd->data.text.value = rnd_strdup(val);
+			}
+			return nd;
+
+		case SNAP_LIST:
+		case SNAP_HASH:
+			if (snap_get_num(rctx, &cnt) != 0)
+				return NULL;
+			nd = lht_dom_node_alloc((type == SNAP_LIST ? LHT_LIST : LHT_HASH), name);
+			nd->doc = rctx->doc;
+			for(n = 0; n < cnt; n++) {
+				ch = snap_get_node(rctx, depth+1);
+				if (ch == NULL)
+					goto error;
+				if (type == SNAP_LIST)
+					lht_dom_list_append(nd, ch);
+				else if (lht_dom_hash_put(nd, ch) != LHTE_SUCCESS) {
+					lht_dom_node_free(ch);
+					goto error;
+				}
+			}
+			return nd;
+
+		case SNAP_TABLE:
+			if ((snap_get_num(rctx, &rows) != 0) || (snap_get_num(rctx, &cols) != 0))
+				return NULL;
+			if ((rows > 0) && ((cols == 0) || (rows > (unsigned long)(rctx->end - rctx->p))))
+				return NULL;
+			nd = lht_dom_node_alloc(LHT_TABLE, name);
+			nd->doc = rctx->doc;
+			nd->data.table.cols = nd->data.table.cols_alloced = cols;
+			for(r = 0; r < rows; r++) {
+				lht_tree_table_ins_row(nd, r);
+				for(c = 0; c < cols; c++) {
+					ch = snap_get_node(rctx, depth+1);
+					if (ch == NULL)
+						goto error;
+					lht_dom_node_free(nd->data.table.r[r][c]);
+					nd->data.table.r[r][c] = ch;
+					ch->parent = nd;
+				}
+			}
+			return nd;
+	}
+
+	return NULL;
+
+	error:;
+	lht_dom_node_free(nd);
+	return NULL;
+}
+
+int io_lihata_snapshot_parse_pcb(pcb_plug_io_t *ctx, pcb_board_t *Ptr, const char *Filename, rnd_conf_role_t settings_dest)
+{
+	FILE *f;
+	long len;
+	unsigned char *img;
+	snap_read_t rctx;
+	int res = -1;
+
+	f = rnd_fopen(&Ptr->hidlib, Filename, "rb");
+	if (f == NULL) {
+		rnd_message(RND_MSG_ERROR, "Error loading '%s': can't open the file for read\n", Filename);
+		return -1;
+	}
+
+	/* load the whole file image in one read; strings are used in place */
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	rewind(f);
+	if (len < (long)SNAP_MAGIC_LEN + 1) {
+		fclose(f);
+		rnd_message(RND_MSG_ERROR, "Error loading '%s': file too short for a board snapshot\n", Filename);
+		return -1;
+	}
+	img = malloc(len);
+	if (fread(img, 1, len, f) != (size_t)len) {
+		fclose(f);
+		free(img);
+		rnd_message(RND_MSG_ERROR, "Error loading '%s': read error\n", Filename);
+		return -1;
+	}
+	fclose(f);
+
+	if (memcmp(img, SNAP_MAGIC, SNAP_MAGIC_LEN) != 0) {
+		free(img);
+		rnd_message(RND_MSG_ERROR, "Error loading '%s': not a pcb-rnd board snapshot\n", Filename);
+		return -1;
+	}
+
+	rctx.p = img + SNAP_MAGIC_LEN;
+	rctx.end = img + len;
+	rctx.doc = lht_dom_init();
+	vtp0_init(&rctx.names);
+
+	rctx.doc->root = snap_get_node(&rctx, 0);
+	if ((rctx.doc->root == NULL) || (rctx.p >= rctx.end) || (*rctx.p != SNAP_END)) {
+		rnd_message(RND_MSG_ERROR, "Error loading '%s': broken or truncated board snapshot\n", Filename);
+		if (rctx.doc->root != NULL) {
+			lht_dom_node_free(rctx.doc->root);
+			rctx.doc->root = NULL;
+		}
+	}
+	else
+		res = io_lihata_parse_board_doc(Ptr, rctx.doc, settings_dest);
+
+	vtp0_uninit(&rctx.names);
+	lht_dom_uninit(rctx.doc);
+	free(img);
+	return res;
+}
@@ -1919,6 +1919,11 @@ static lht_doc_t *build_board(pcb_board_t *pcb)
 
 static lhtpers_ev_res_t check_text(void *ev_ctx, lht_perstyle_t *style, lht_node_t *inmem_node, const char *ondisk_value)
 {
+	/* most values are unchanged since the last save; identical strings are
+	   identical values too, no need to look up rules and convert */
+	if ((inmem_node->data.text.value != NULL) && (strcmp(inmem_node->data.text.value, ondisk_value) == 0))
+		return LHTPERS_DISK;
+
 	/* for coords, preserve formatting as long as values match */
 	if (lhtpers_rule_find(io_lihata_out_coords, inmem_node) != NULL) {
 		rnd_coord_t v1, v2;
@@ -1977,6 +1982,17 @@ static void clean_invalid(lht_node_t *node)
 	}
 }
 
+lht_doc_t *io_lihata_build_board_doc(pcb_board_t *pcb, int ver)
+{
+	lht_doc_t *brd;
+
+	wrver = ver;
+	brd = build_board(pcb);
+	if (brd != NULL)
+		clean_invalid(brd->root);
+	return brd;
+}
+
 static int io_lihata_write_pcb(pcb_plug_io_t *ctx, FILE * FP, const char *old_filename, const char *new_filename, rnd_bool emergency, int ver)
 {
 	int res;
@@ -2021,8 +2037,9 @@ static int io_lihata_write_pcb(pcb_plug_io_t *ctx, FILE * FP, const char *old_fi
 	}
 #endif
 
-	if ((emergency) || ((old_filename == NULL) && (new_filename == NULL))) {
-		/* emergency or pipe save: use the canonical form */
+	if ((emergency) || ((old_filename == NULL) && (new_filename == NULL)) || conf_io_lihata.plugins.io_lihata.fast_save) {
+		/* emergency (including backup), pipe or fast save: use the canonical
+		   form, there's no on-disk formatting to preserve */
 		clean_invalid(brd->root); /* remove invalid nodes placed for persistency */
 		res = lht_dom_export(brd->root, FP, "");
 	}
@@ -2295,7 +2312,7 @@ int io_lihata_write_padstack(pcb_plug_io_t *ctx, FILE *f, pcb_pstk_proto_t *prot
 }
 
 typedef struct {
-	int womit_font, womit_config, womit_styles, wdenoise;
+	int womit_font, womit_config, womit_styles, wdenoise, wfast_save;
 	int ver;
 } io_lihata_save_t;
 
@@ -2320,6 +2337,13 @@ void *io_lihata_save_as_subd_init(const pcb_plug_io_t *ctx, rnd_hid_dad_subdialo
 						RND_DAD_DEFAULT_NUM(sub->dlg, !!conf_io_lihata.plugins.io_lihata.omit_config);
 						save->womit_config = RND_DAD_CURRENT(sub->dlg);
 				RND_DAD_END(sub->dlg);
+				RND_DAD_BEGIN_HBOX(sub->dlg);
+					RND_DAD_LABEL(sub->dlg, "Fast save");
+						RND_DAD_HELP(sub->dlg, "Write the canonical form without\npreserving the formatting of the file\nbeing overwritten; much faster on\nlarge boards, but reformats the file");
+					RND_DAD_BOOL(sub->dlg);
+						RND_DAD_DEFAULT_NUM(sub->dlg, !!conf_io_lihata.plugins.io_lihata.fast_save);
+						save->wfast_save = RND_DAD_CURRENT(sub->dlg);
+				RND_DAD_END(sub->dlg);
 			RND_DAD_END(sub->dlg);
 
 			RND_DAD_BEGIN_HBOX(sub->dlg);
@@ -2356,6 +2380,7 @@ void io_lihata_save_as_subd_uninit(const pcb_plug_io_t *ctx, void *plg_ctx, rnd_
 		int omit_config = !!sub->dlg[save->womit_config].val.lng;
 		int omit_styles = !!sub->dlg[save->womit_styles].val.lng;
 		int denoise = !!sub->dlg[save->wdenoise].val.lng;
+		int fast_save = !!sub->dlg[save->wfast_save].val.lng;
 
 		if (omit_font != !!conf_io_lihata.plugins.io_lihata.omit_font)
 			rnd_conf_setf(RND_CFR_CLI, "plugins/io_lihata/omit_font", 0, "%d", omit_font);
@@ -2368,6 +2393,9 @@ void io_lihata_save_as_subd_uninit(const pcb_plug_io_t *ctx, void *plg_ctx, rnd_
 
 		if (denoise != !!conf_io_lihata.plugins.io_lihata.denoise)
 			rnd_conf_setf(RND_CFR_CLI, "plugins/io_lihata/denoise", 0, "%d", denoise);
+
+		if (fast_save != !!conf_io_lihata.plugins.io_lihata.fast_save)
+			rnd_conf_setf(RND_CFR_CLI, "plugins/io_lihata/fast_save", 0, "%d", fast_save);
 	}
 
 	free(save);
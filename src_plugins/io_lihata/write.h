@@ -24,6 +24,7 @@
  *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
  */
 
+#include <liblihata/dom.h>
 #include "plug_io.h"
 
 int io_lihata_write_pcb_v1(pcb_plug_io_t *ctx, FILE *FP, const char *old_filename, const char *new_filename, rnd_bool emergency);
@@ -45,3 +46,8 @@ int io_lihata_write_padstack(pcb_plug_io_t *ctx, FILE *f, pcb_pstk_proto_t *prot
 void *io_lihata_save_as_subd_init(const pcb_plug_io_t *ctx, rnd_hid_dad_subdialog_t *sub, pcb_plug_iot_t type);
 void io_lihata_save_as_subd_uninit(const pcb_plug_io_t *ctx, void *plg_ctx, rnd_hid_dad_subdialog_t *sub, rnd_bool apply);
 void io_lihata_save_as_fmt_changed(const pcb_plug_io_t *ctx, void *plg_ctx, rnd_hid_dad_subdialog_t *sub);
+
+/* Build the in-memory lihata document of a board at version ver, in
+   canonical form (no placeholder nodes); returns NULL on error. The caller
+   needs to lht_dom_uninit() the document. */
+lht_doc_t *io_lihata_build_board_doc(pcb_board_t *pcb, int ver);
@@ -2871,6 +2871,7 @@ int io_pcb_ParsePCB(pcb_plug_io_t *ctx, pcb_board_t *Ptr, const char *Filename,
 	}
 	pcb_layer_auto_fixup(PCB);
 	io_pcb_postproc_board(PCB);
+	pcb_data_rtree_repack(PCB->Data);
 	pcb_data_clip_inhibit_dec(PCB->Data, 1);
 	return retval;
 }
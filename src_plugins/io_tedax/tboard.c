@@ -559,5 +559,7 @@ int tedax_board_load(pcb_board_t *pcb, const char *fn, const char *blk_id, int s
 	}
 	res = tedax_board_fload(pcb, f, blk_id, silent);
 	fclose(f);
+	if (res == 0)
+		pcb_data_rtree_repack(pcb->Data);
 	return res;
 }
@@ -113,6 +113,7 @@ static void dump_lib_any(int level, pcb_fplibrary_t *l)
 
 static fgw_error_t pcb_act_DumpLibrary(fgw_arg_t *res, int argc, fgw_arg_t *argv)
 {
+	pcb_fp_lib_expand_all(&pcb_library);
 	dump_lib_any(0, &pcb_library);
 
 	RND_ACT_IRES(0);
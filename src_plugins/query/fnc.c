@@ -161,6 +161,7 @@ void pcb_qry_basic_fnc_init(void)
 	pcb_qry_fnc_reg("netsegs", fnc_netsegs);
 	pcb_qry_fnc_reg("netbreak", fnc_netbreak);
 	pcb_qry_fnc_reg("netshort", fnc_netshort);
+	pcb_qry_fnc_reg("sameseg", fnc_sameseg);
 	pcb_qry_fnc_reg("subcobjs", fnc_subcobjs);
 	pcb_qry_fnc_reg("action", fnc_action);
 	pcb_qry_fnc_reg("getconf", pcb_qry_fnc_getconf);
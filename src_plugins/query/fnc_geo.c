@@ -134,6 +134,7 @@ static int fnc_intersect(pcb_qry_exec_t *ectx, int argc, pcb_qry_val_t *argv, pc
 {
 	static pcb_find_t fctx = {0};
 
+	fctx.bloat = 0;
 	fctx.ignore_clearance = 1;
 	fctx.allow_noncopper_pstk = 1;
 
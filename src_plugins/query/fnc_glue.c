@@ -210,6 +210,14 @@ static int fnc_netshort(pcb_qry_exec_t *ectx, int argc, pcb_qry_val_t *argv, pcb
 	return fnc_netint_any(ectx, argc, argv, res, 0);
 }
 
+static int fnc_sameseg(pcb_qry_exec_t *ectx, int argc, pcb_qry_val_t *argv, pcb_qry_val_t *res)
+{
+	if ((argc != 2) || (argv[0].type != PCBQ_VT_OBJ) || (argv[1].type != PCBQ_VT_OBJ))
+		return -1;
+
+	PCB_QRY_RET_INT(res, pcb_find_same_island(ectx->pcb, argv[0].data.obj, argv[1].data.obj));
+}
+
 int pcb_qry_fnc_getconf(pcb_qry_exec_t *ectx, int argc, pcb_qry_val_t *argv, pcb_qry_val_t *res)
 {
 	rnd_conf_native_t *nat;
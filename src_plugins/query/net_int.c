@@ -147,12 +147,39 @@ static int parent_net_term_found_cb(pcb_find_t *fctx, pcb_any_obj_t *new_obj, pc
 }
 
 
+/* pick the result for a segment and remember it for all objects of the segment */
+static pcb_any_obj_t *parent_net_term_set(pcb_qry_exec_t *ec, pcb_any_obj_t *best_term, pcb_any_obj_t *best_nonterm, vtp0_t *objs)
+{
+	pcb_any_obj_t *res;
+	long n;
+
+	/* for terminals do the expensive lookup and return the PCB_OBJ_NET_TERM object */
+	if (best_term != NULL) {
+		pcb_net_term_t *t;
+		t = pcb_net_find_by_obj(&ec->pcb->netlist[PCB_NETLIST_EDITED], best_term);
+		res = (t == NULL) ? best_term : (pcb_any_obj_t *)t;
+	}
+	else
+		res = best_nonterm;
+
+	for(n = 0; n < objs->used; n++)
+		htpp_set(&ec->obj2netterm, objs->array[n], res);
+
+	return res;
+}
+
 RND_INLINE pcb_any_obj_t *pcb_qry_parent_net_term_(pcb_qry_exec_t *ec, pcb_any_obj_t *from)
 {
 	pcb_find_t fctx;
 	parent_net_term_t ctx;
 	pcb_any_obj_t *res = NULL;
-	long n;
+	pcb_find_island_t *isl;
+
+	/* the segment may already be mapped on the board level, e.g. by a
+	   previous query or DRC run */
+	isl = pcb_find_island(ec->pcb, from);
+	if (isl != NULL)
+		return parent_net_term_set(ec, isl->best_term, isl->best_nonterm, &isl->objs);
 
 	assert(ec->tmplst.used == 0); /* temp list must be empty so we are nto getting void * ptrs to anything else than we find */
 
@@ -166,18 +193,7 @@ RND_INLINE pcb_any_obj_t *pcb_qry_parent_net_term_(pcb_qry_exec_t *ec, pcb_any_o
 	pcb_find_from_obj(&fctx, ec->pcb->Data, from);
 	pcb_find_free(&fctx);
 
-	/* for terminals do the expensive lookup and return the PCB_OBJ_NET_TERM object */
-	if (ctx.best_term != NULL) {
-		pcb_net_term_t *t;
-		t = pcb_net_find_by_obj(&ec->pcb->netlist[PCB_NETLIST_EDITED], ctx.best_term);
-		res = (t == NULL) ? ctx.best_term : (pcb_any_obj_t *)t;
-	}
-	else
-		res = ctx.best_nonterm;
-
-	for(n = 0; n < ec->tmplst.used; n++)
-		htpp_set(&ec->obj2netterm, ec->tmplst.array[n], res);
-
+	res = parent_net_term_set(ec, ctx.best_term, ctx.best_nonterm, &ec->tmplst);
 	ec->tmplst.used = 0;
 
 	return res;
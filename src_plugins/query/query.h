@@ -211,6 +211,11 @@ pcb_qry_node_t *pcb_query_compile(const char *script);
    is total number of definition usage. */
 int pcb_qry_extract_defs(htsi_t *dst, const char *script);
 
+/* Same as pcb_qry_extract_defs(), but also counts all other config reads of
+   the script in other_conf: getconf() calls on a path outside of
+   design/drc/ or on a path computed runtime */
+int pcb_qry_extract_conf_deps(htsi_t *dst, const char *script, int *other_conf);
+
 /*** drc list-reports ***/
 
 /* dynamic alloced fake objects that store constants */
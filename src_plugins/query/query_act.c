@@ -35,6 +35,7 @@
 #include "query.h"
 #include "query_y.h"
 #include "query_exec.h"
+#include "query_plan.h"
 #include "query_access.h"
 #include "draw.h"
 #include "select.h"
@@ -48,6 +49,8 @@
 
 static const char pcb_acts_query[] =
 	"query(dump, expr) - dry run: compile and dump an expression\n"
+	"query(explain, expr) - dry run: compile an expression or rules and print the execution plan of each assert\n"
+	"query(plan, join|cartesian) - execute asserts using the bbox join where possible (default) or always as a cartesian product\n"
 	"query(eval|evalidp, expr, [scope]) - compile and evaluate an expression and print a list of results on stdout\n"
 	"query(count, expr, [scope]) - compile and evaluate an expression and return the number of matched objects (-1 on error)\n"
 	"query(select|unselect|view, expr, [scope]) - select or unselect or build a view of objects matching an expression\n"
@@ -229,14 +232,18 @@ int pcb_qry_run_script(pcb_qry_exec_t *ec, pcb_board_t *pcb, const char *script,
 }
 
 extern int pcb_qry_fnc_getconf(pcb_qry_exec_t *ectx, int argc, pcb_qry_val_t *argv, pcb_qry_val_t *res);
-static void pcb_qry_extract_defs_(htsi_t *dst, pcb_qry_node_t *nd, int *total)
+static void pcb_qry_extract_defs_(htsi_t *dst, pcb_qry_node_t *nd, int *total, int *other_conf)
 {
 	if (nd->type == PCBQ_FCALL) {
 		pcb_qry_node_t *fname = nd->data.children;
-		if ((fname->type == PCBQ_FNAME) && (fname->precomp.fnc.bui == pcb_qry_fnc_getconf) && (fname->next->type == PCBQ_DATA_STRING)) {
-			const char *name = fname->next->data.str;
+		if ((fname->type == PCBQ_FNAME) && (fname->precomp.fnc.bui == pcb_qry_fnc_getconf)) {
+			const char *name = NULL;
 			htsi_entry_t *e;
-			if (strncmp(name, "design/drc/", 11) == 0) {
+
+			if ((fname->next != NULL) && (fname->next->type == PCBQ_DATA_STRING))
+				name = fname->next->data.str;
+
+			if ((name != NULL) && (strncmp(name, "design/drc/", 11) == 0)) {
 				name += 11;
 				e = htsi_getentry(dst, name);
 				if (e == NULL) {
@@ -246,38 +253,48 @@ static void pcb_qry_extract_defs_(htsi_t *dst, pcb_qry_node_t *nd, int *total)
 				e->value++;
 				(*total)++;
 			}
+			else if (other_conf != NULL) /* not a definition or path computed runtime */
+				(*other_conf)++;
 		}
 	}
 
 	/* RULE needs special recursion */
 	if (nd->type == PCBQ_RULE) {
 		for(nd = nd->data.children->next->next; nd != NULL; nd = nd->next)
-			pcb_qry_extract_defs_(dst, nd, total);
+			pcb_qry_extract_defs_(dst, nd, total, other_conf);
 		return;
 	}
 
 	/* recurse */
 	if (pcb_qry_nodetype_has_children(nd->type))
 		for(nd = nd->data.children; nd != NULL; nd = nd->next)
-			pcb_qry_extract_defs_(dst, nd, total);
+			pcb_qry_extract_defs_(dst, nd, total, other_conf);
 }
 
-int pcb_qry_extract_defs(htsi_t *dst, const char *script)
+int pcb_qry_extract_conf_deps(htsi_t *dst, const char *script, int *other_conf)
 {
 	pcb_qry_node_t *prg = NULL;
 	int total = 0;
 
+	if (other_conf != NULL)
+		*other_conf = 0;
+
 	pcb_qry_set_input(script);
 	qry_parse(&prg);
 	if (prg == NULL)
 		return -1;
 
-	pcb_qry_extract_defs_(dst, prg, &total);
+	pcb_qry_extract_defs_(dst, prg, &total, other_conf);
 
 	pcb_qry_n_free(prg);
 	return total;
 }
 
+int pcb_qry_extract_defs(htsi_t *dst, const char *script)
+{
+	return pcb_qry_extract_conf_deps(dst, script, NULL);
+}
+
 
 static fgw_error_t pcb_act_query(fgw_arg_t *res, int argc, fgw_arg_t *argv)
 {
@@ -311,6 +328,37 @@ static fgw_error_t pcb_act_query(fgw_arg_t *res, int argc, fgw_arg_t *argv)
 		return 0;
 	}
 
+	if (strcmp(cmd, "explain") == 0) {
+		pcb_qry_node_t *prg;
+
+		RND_ACT_MAY_CONVARG(2, FGW_STR, query, arg = argv[2].val.str);
+		printf("Script explain: '%s'\n", arg);
+		prg = pcb_query_compile(arg);
+		if (prg != NULL) {
+			pcb_qry_plan_explain(stdout, prg);
+			pcb_qry_n_free(prg);
+			RND_ACT_IRES(0);
+		}
+		else
+			RND_ACT_IRES(1);
+		return 0;
+	}
+
+	if (strcmp(cmd, "plan") == 0) {
+		RND_ACT_CONVARG(2, FGW_STR, query, arg = argv[2].val.str);
+		if (strcmp(arg, "join") == 0)
+			pcb_qry_plan_join = 1;
+		else if (strcmp(arg, "cartesian") == 0)
+			pcb_qry_plan_join = 0;
+		else {
+			rnd_message(RND_MSG_ERROR, "query(plan): invalid plan '%s' (should be join or cartesian)\n", arg);
+			RND_ACT_IRES(1);
+			return 0;
+		}
+		RND_ACT_IRES(0);
+		return 0;
+	}
+
 	if ((strcmp(cmd, "eval") == 0) || (strcmp(cmd, "evalidp") == 0)) {
 		int errs;
 		eval_stat_t st;
@@ -27,13 +27,18 @@
 /* Query language - execution */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "config.h"
 #include "data.h"
 #include "query.h"
 #include "query_exec.h"
 #include "query_access.h"
+#include "query_plan.h"
 #include "net_len.h"
+#include <genht/hash.h>
+#include <genvector/gds_char.h>
 #include <librnd/core/rnd_printf.h>
+#include <librnd/poly/rtree.h>
 
 #define PCB dontuse
 
@@ -98,12 +103,23 @@ void pcb_qry_uninit(pcb_qry_exec_t *ctx)
 		vtp0_uninit(&ctx->obj2lenseg_free);
 	}
 
+	if (ctx->let_cache_inited) {
+		htsp_entry_t *e;
+		for(e = htsp_first(&ctx->let_cache); e != NULL; e = htsp_next(&ctx->let_cache, e)) {
+			vtp0_uninit(e->value);
+			free(e->value);
+			free(e->key);
+		}
+		htsp_uninit(&ctx->let_cache);
+	}
+
 	vtp0_uninit(&ctx->tmplst);
 	pcb_qry_uninit_layer_setup(ctx);
 	pcb_qry_uninit_layer_ko_match(ctx);
 
 	ctx->obj2netterm_inited = ctx->obj2lenseg_inited = \
-	ctx->layer_setup_inited = ctx->warned_missing_thickness = 0;
+	ctx->layer_setup_inited = ctx->let_cache_inited = \
+	ctx->warned_missing_thickness = 0;
 }
 
 static void val_free_fields(pcb_qry_val_t *val)
@@ -182,11 +198,79 @@ static void let_cb(void *user_ctx, pcb_qry_val_t *res, pcb_any_obj_t *current)
 		vtp0_append(lctx->vt, current);
 }
 
+/* Serialize a let expression into dst so that equal expressions of
+   different rules result in the same string. Returns -1 if the expression
+   depends on anything else than @ and the board (other iterators, lists,
+   user functions): such a result can not be reused by another rule. */
+static int let_cache_key(pcb_query_iter_t *it, gds_t *dst, pcb_qry_node_t *nd)
+{
+	pcb_qry_node_t *n;
+	const char *s;
+
+	rnd_append_printf(dst, "(%d", nd->type);
+	switch(nd->type) {
+		case PCBQ_VAR:
+			if (strcmp(it->vn[nd->data.crd], "@") != 0)
+				return -1;
+			break;
+		case PCBQ_FNAME:
+			if (nd->precomp.fnc.bui == NULL)
+				return -1;
+			s = pcb_qry_fnc_name(nd->precomp.fnc.bui);
+			if ((s == NULL) || (strcmp(s, "action") == 0)) /* action() may have side effects */
+				return -1;
+			rnd_append_printf(dst, " %s", s);
+			break;
+		case PCBQ_FIELD:
+			s = (nd->data.str == NULL) ? "" : nd->data.str;
+			rnd_append_printf(dst, " %d %ld:%s", nd->precomp.fld, (long)strlen(s), s);
+			break;
+		case PCBQ_DATA_STRING:
+		case PCBQ_DATA_REGEX:
+			s = (nd->data.str == NULL) ? "" : nd->data.str;
+			rnd_append_printf(dst, " %ld:%s", (long)strlen(s), s);
+			break;
+		case PCBQ_DATA_COORD:    rnd_append_printf(dst, " %ld", (long)nd->data.crd); break;
+		case PCBQ_DATA_DOUBLE:   rnd_append_printf(dst, " %.17g", nd->data.dbl); break;
+		case PCBQ_DATA_CONST:    rnd_append_printf(dst, " %ld", nd->precomp.cnst); break;
+		case PCBQ_DATA_OBJ:      rnd_append_printf(dst, " %p", (void *)nd->precomp.obj); break;
+		case PCBQ_FLAG:          rnd_append_printf(dst, " %p", (void *)nd->precomp.flg); break;
+		case PCBQ_DATA_LYTC:     rnd_append_printf(dst, " %ld %ld", (long)nd->data.lytc.lyt, (long)nd->data.lytc.lyc); break;
+		case PCBQ_DATA_INVALID:  break;
+
+		case PCBQ_LISTVAR:
+		case PCBQ_RULE:
+		case PCBQ_RNAME:
+		case PCBQ_EXPR_PROG:
+		case PCBQ_ASSERT:
+		case PCBQ_ITER_CTX:
+		case PCBQ_LET:
+		case PCBQ_FUNCTION:
+		case PCBQ_RETURN:
+		case PCBQ_ARG:
+		case PCBQ_nodetype_max:
+			return -1;
+
+		default:
+			if (!pcb_qry_nodetype_has_children(nd->type))
+				return -1;
+			for(n = nd->data.children; n != NULL; n = n->next)
+				if (let_cache_key(it, dst, n) != 0)
+					return -1;
+	}
+	gds_append(dst, ')');
+	return 0;
+}
+
 static void pcb_qry_let(pcb_qry_exec_t *ctx, pcb_qry_node_t *node)
 {
 	let_ctx_t lctx;
 	int vi = node->data.children->data.crd;
 	pcb_qry_node_t *expr = node->data.children->next;
+	gds_t key;
+	vtp0_t *cached;
+	long n;
+	int cacheable;
 
 	lctx.ctx = ctx;
 	pcb_qry_it_reset(ctx, node);
@@ -195,17 +279,49 @@ static void pcb_qry_let(pcb_qry_exec_t *ctx, pcb_qry_node_t *node)
 	ctx->iter->lst[vi].type = PCBQ_VT_LST;
 	lctx.vt = &ctx->iter->lst[vi].data.lst;
 
+	/* many rules start with the same 'let A @.type==LINE'-like filter; if
+	   another rule of this context already computed it, just copy the result */
+	gds_init(&key);
+	cacheable = (let_cache_key(ctx->iter, &key, expr) == 0);
+	if (cacheable) {
+		if (!ctx->let_cache_inited) {
+			htsp_init(&ctx->let_cache, strhash, strkeyeq);
+			ctx->let_cache_inited = 1;
+		}
+		cached = htsp_get(&ctx->let_cache, key.array);
+		if (cached != NULL) {
+			for(n = 0; n < cached->used; n++)
+				vtp0_append(lctx.vt, cached->array[n]);
+			gds_uninit(&key);
+			goto done;
+		}
+	}
+	else
+		gds_uninit(&key);
+
 	/* evaluate 'let' the expression, filling up the list */
 	pcb_qry_it_reset_(lctx.ctx, 0);
 	ctx->iter->it_active = node->precomp.it_active;
 	pcb_qry_run_(lctx.ctx, expr, NULL, 0, 1,let_cb, &lctx);
 	ctx->iter->it_active = NULL;
 
+	if (cacheable) { /* remember the result for other rules */
+		cached = malloc(sizeof(vtp0_t));
+		vtp0_init(cached);
+		for(n = 0; n < lctx.vt->used; n++)
+			vtp0_append(cached, lctx.vt->array[n]);
+		htsp_set(&ctx->let_cache, key.array, cached);
+	}
+
+	done:;
+
 	/* initialize the iterator */
 	ctx->iter->vects[vi] = &ctx->iter->lst[vi].data.lst;
 	ctx->iter->idx[vi] = 0;
 }
 
+static int pcb_qry_run_join(pcb_qry_exec_t *ec, const pcb_qry_plan_t *plan, pcb_qry_node_t *prg, void (*cb)(void *user_ctx, pcb_qry_val_t *res, pcb_any_obj_t *current), void *user_ctx);
+
 /* Run one node; increment ret by the number of hits and return that, or -1 on error.
    If res is not NULL the value of PCBQ_RETURN is loaded in it.
    Call cb/user_ctx when assert is true. */
@@ -250,7 +366,15 @@ static int pcb_qry_run_one(pcb_qry_exec_t *ec, pcb_qry_node_t *prg, int ret, pcb
 					ec->root = n;
 					if (ec->iter != NULL)
 						ec->iter->it_active = n->precomp.it_active;
-					r = pcb_qry_run_(ec, n->data.children, (is_ret ? res : NULL), 1, 0, (n->type == PCBQ_RETURN ? NULL : cb), user_ctx);
+					r = -2;
+					if (n->type == PCBQ_ASSERT) {
+						pcb_qry_plan_t plan;
+						pcb_qry_plan_assert(n, &plan);
+						if ((plan.type == PCB_QRY_PLAN_BBOX_JOIN) && (pcb_qry_it_reset(ec, n->data.children) == 0))
+							r = pcb_qry_run_join(ec, &plan, n->data.children, cb, user_ctx);
+					}
+					if (r == -2) /* no plan or the plan is not applicable: do the cartesian */
+						r = pcb_qry_run_(ec, n->data.children, (is_ret ? res : NULL), 1, 0, (n->type == PCBQ_RETURN ? NULL : cb), user_ctx);
 					if (ec->iter != NULL)
 						ec->iter->it_active = NULL;
 					if (r < 0)
@@ -553,6 +677,107 @@ int pcb_qry_it_next(pcb_qry_exec_t *ctx)
 	return 0;
 }
 
+typedef struct {
+	rnd_rtree_box_t box;
+	long idx;
+} qry_join_box_t;
+
+static int cmp_join_box(const void *a_, const void *b_)
+{
+	const qry_join_box_t * const *a = a_, * const *b = b_;
+	return ((*a)->idx < (*b)->idx) ? -1 : +1;
+}
+
+/* Execute a PCB_QRY_PLAN_BBOX_JOIN: put the inner list in an rtree and
+   for each object of the outer list evaluate prg only with inner objects
+   whose bounding box is close enough; everything else would fail the join
+   predicate anyway. Evaluation order is the same as in the cartesian
+   iteration. Returns the number of errors like pcb_qry_run_() or -2 if
+   the plan can not be applied (the caller should fall back to cartesian). */
+static int pcb_qry_run_join(pcb_qry_exec_t *ec, const pcb_qry_plan_t *plan, pcb_qry_node_t *prg, void (*cb)(void *user_ctx, pcb_qry_val_t *res, pcb_any_obj_t *current), void *user_ctx)
+{
+	pcb_query_iter_t *iter = ec->iter;
+	vtp0_t *ov, *iv, hits;
+	rnd_rtree_t tree;
+	rnd_rtree_it_t it;
+	qry_join_box_t *boxes, *jb;
+	pcb_qry_val_t res;
+	rnd_coord_t bloat = 0;
+	long oi, n;
+	int errs = 0;
+
+	ov = iter->vects[plan->outer];
+	iv = iter->vects[plan->inner];
+	if ((ov == NULL) || (iv == NULL) || (ov->used == 0) || (iv->used == 0))
+		return -2;
+
+	if (plan->bloat != NULL) {
+		pcb_qry_val_t bv;
+		bv.type = PCBQ_VT_VOID;
+		if (pcb_qry_eval(ec, plan->bloat, &bv, NULL, NULL) != 0)
+			return -2;
+		PCB_QRY_ARG_CONV_TO_COORD(bloat, &bv, return -2);
+		if (bloat < 0) /* shrinking: the unbloated bbox is still a safe prefilter */
+			bloat = 0;
+		bloat *= 2; /* some of the low level isc functions apply bloat on both objects */
+	}
+
+	rnd_rtree_init(&tree);
+	boxes = malloc(sizeof(qry_join_box_t) * iv->used);
+	for(n = 0, jb = boxes; n < iv->used; n++) {
+		pcb_any_obj_t *o = iv->array[n];
+		if (o == NULL)
+			continue;
+		jb->box.x1 = o->BoundingBox.X1; jb->box.y1 = o->BoundingBox.Y1;
+		jb->box.x2 = o->BoundingBox.X2; jb->box.y2 = o->BoundingBox.Y2;
+		jb->idx = n;
+		rnd_rtree_insert(&tree, jb, &jb->box);
+		jb++;
+	}
+
+	vtp0_init(&hits);
+	for(oi = 0; oi < ov->used; oi++) {
+		pcb_any_obj_t *o = ov->array[oi];
+		rnd_rtree_box_t sb;
+		int cancel;
+
+		PROGRESS_CB(ec, oi, ov->used, cancel);
+		if (cancel)
+			break;
+
+		if (o == NULL)
+			continue;
+
+		sb.x1 = o->BoundingBox.X1 - bloat - 1; sb.y1 = o->BoundingBox.Y1 - bloat - 1;
+		sb.x2 = o->BoundingBox.X2 + bloat + 1; sb.y2 = o->BoundingBox.Y2 + bloat + 1;
+
+		hits.used = 0;
+		for(jb = rnd_rtree_first(&it, &tree, &sb); jb != NULL; jb = rnd_rtree_next(&it))
+			vtp0_append(&hits, jb);
+		if (hits.used > 1)
+			qsort(hits.array, hits.used, sizeof(void *), cmp_join_box);
+
+		iter->idx[plan->outer] = oi;
+		for(n = 0; n < hits.used; n++) {
+			jb = hits.array[n];
+			iter->idx[plan->inner] = jb->idx;
+			res.type = PCBQ_VT_VOID;
+			if ((pcb_qry_eval(ec, prg, &res, cb, user_ctx) == 0) && (cb != NULL)) {
+				if (iter->last_obj != NULL)
+					cb(user_ctx, &res, iter->last_obj);
+			}
+			else
+				errs++;
+			val_free_fields(&res);
+		}
+	}
+
+	iter->idx[plan->outer] = iter->idx[plan->inner] = 0;
+	vtp0_uninit(&hits);
+	rnd_rtree_uninit(&tree);
+	free(boxes);
+	return errs;
+}
 
 /* load s1 and s2 from o1 and o2, convert empty string to NULL */
 #define load_strings_null() \
@@ -32,6 +32,7 @@
 #include "query.h"
 #include <genht/htpp.h>
 #include <genht/htpi.h>
+#include <genht/htsp.h>
 #include <time.h>
 
 #define PCB_QRY_MAX_FUNC_ARGS 64
@@ -58,11 +59,13 @@ struct pcb_qry_exec_s {
 	void *layer_setup_res_cache; /* fnc layer_setup(): cached results for each condition evaluated - requests tend to repeat */
 	time_t last_prog_cb;
 	void *layer_ko_match;       /* fnc layer_ko_match(); key is a fake pointer build of two layer group indices */
+	htsp_t let_cache;     /* key is a serialized 'let' expression that depends only on @, value is (vtp0_t *) list of resulting objects; shared among rules running with the same context */
 
 	unsigned obj2netterm_inited:1;
 	unsigned obj2lenseg_inited:1;
 	unsigned layer_setup_inited:1;
 	unsigned layer_ko_match_inited:1;
+	unsigned let_cache_inited:1;
 	unsigned warned_missing_thickness:1;
 	unsigned trace:1;
 };
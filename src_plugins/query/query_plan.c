@@ -0,0 +1,212 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  pcb-rnd, interactive printed circuit board design
+ *  Copyright (C) 2024 Tibor 'Igor2' Palinkas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  Contact:
+ *    Project page: http://repo.hu/projects/pcb-rnd
+ *    lead developer: http://repo.hu/projects/pcb-rnd/contact.html
+ *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
+ */
+
+/* Query language - execution planner */
+
+#include "config.h"
+#include <string.h>
+#include "query.h"
+#include "query_plan.h"
+
+#define PCB dontuse
+
+int pcb_qry_plan_join = 1;
+
+/* returns 1 if the subtree of nd refers to any iterator variable */
+static int subtree_has_var(pcb_qry_node_t *nd)
+{
+	pcb_qry_node_t *n;
+
+	if (nd->type == PCBQ_VAR)
+		return 1;
+
+	if (pcb_qry_nodetype_has_children(nd->type))
+		for(n = nd->data.children; n != NULL; n = n->next)
+			if (subtree_has_var(n))
+				return 1;
+
+	return 0;
+}
+
+/* returns 1 if nd is a call to a geometric predicate that can be
+   prefiltered by bounding box: overlap(A, B [,bloat]) or
+   intersect(A, B [,bloat]) with two different iterator variables */
+static int is_join_pred(pcb_qry_node_t *nd)
+{
+	pcb_qry_node_t *fname = nd->data.children, *a1, *a2, *a3;
+	pcb_qry_fnc_t f;
+
+	if ((fname == NULL) || (fname->type != PCBQ_FNAME))
+		return 0;
+
+	f = fname->precomp.fnc.bui;
+	if ((f == NULL) || ((f != pcb_qry_fnc_lookup("overlap")) && (f != pcb_qry_fnc_lookup("intersect"))))
+		return 0;
+
+	a1 = fname->next;
+	if ((a1 == NULL) || (a1->type != PCBQ_VAR))
+		return 0;
+	a2 = a1->next;
+	if ((a2 == NULL) || (a2->type != PCBQ_VAR) || (a1->data.crd == a2->data.crd))
+		return 0;
+
+	a3 = a2->next;
+	if (a3 != NULL) {
+		if ((a3->next != NULL) || subtree_has_var(a3))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Search the part of the expression that needs to be true for the whole
+   expression to be true: operands of AND and the condition of THUS */
+static pcb_qry_node_t *find_join_pred(pcb_qry_node_t *nd)
+{
+	pcb_qry_node_t *res;
+
+	if (nd == NULL)
+		return NULL;
+
+	switch(nd->type) {
+		case PCBQ_EXPR:
+			return find_join_pred(nd->data.children);
+
+		case PCBQ_OP_AND:
+			res = find_join_pred(nd->data.children);
+			if (res != NULL)
+				return res;
+			return find_join_pred(nd->data.children->next);
+
+		case PCBQ_OP_THUS:
+			return find_join_pred(nd->data.children);
+
+		case PCBQ_FCALL:
+			if (is_join_pred(nd))
+				return nd;
+			return NULL;
+
+		default:;
+	}
+
+	return NULL;
+}
+
+void pcb_qry_plan_assert(pcb_qry_node_t *assrt, pcb_qry_plan_t *plan)
+{
+	pcb_qry_node_t *pred, *a1, *a2;
+	vti0_t *act;
+	long n;
+
+	memset(plan, 0, sizeof(pcb_qry_plan_t));
+	plan->type = PCB_QRY_PLAN_CARTESIAN;
+
+	if (!pcb_qry_plan_join || (assrt == NULL) || (assrt->type != PCBQ_ASSERT))
+		return;
+
+	pred = find_join_pred(assrt->data.children);
+	if (pred == NULL)
+		return;
+
+	a1 = pred->data.children->next;
+	a2 = a1->next;
+
+	/* any other active iterator would have to be iterated over on top of the
+	   join; keep it simple and let the cartesian code handle those */
+	act = assrt->precomp.it_active;
+	if (act == NULL)
+		return;
+	for(n = 0; n < act->used; n++)
+		if ((act->array[n] != 0) && (n != a1->data.crd) && (n != a2->data.crd))
+			return;
+
+	plan->type = PCB_QRY_PLAN_BBOX_JOIN;
+	if (a1->data.crd > a2->data.crd) {
+		plan->outer = a1->data.crd;
+		plan->inner = a2->data.crd;
+	}
+	else {
+		plan->outer = a2->data.crd;
+		plan->inner = a1->data.crd;
+	}
+	plan->pred = pred;
+	plan->bloat = a2->next;
+}
+
+static void explain_assert(FILE *f, pcb_qry_node_t *assrt, pcb_query_iter_t *it, int idx)
+{
+	pcb_qry_plan_t plan;
+	const char *fname;
+	vti0_t *act = assrt->precomp.it_active;
+	int n;
+
+	pcb_qry_plan_assert(assrt, &plan);
+
+	fprintf(f, " assert #%d: ", idx);
+	switch(plan.type) {
+		case PCB_QRY_PLAN_CARTESIAN:
+			fprintf(f, "cartesian product of");
+			for(n = 0; n < it->num_vars; n++)
+				if ((act == NULL) || ((n < act->used) && (act->array[n] != 0)))
+					fprintf(f, " %s", it->vn[n]);
+			fprintf(f, "\n");
+			break;
+		case PCB_QRY_PLAN_BBOX_JOIN:
+			fname = pcb_qry_fnc_name(plan.pred->data.children->precomp.fnc.bui);
+			fprintf(f, "bbox join on %s()%s: outer=%s inner=%s\n",
+				(fname == NULL ? "<unknown>" : fname), (plan.bloat != NULL ? " with bloat" : ""),
+				it->vn[plan.outer], it->vn[plan.inner]);
+			break;
+	}
+}
+
+void pcb_qry_plan_explain(FILE *f, pcb_qry_node_t *prg)
+{
+	pcb_qry_node_t *nd, *n;
+	pcb_query_iter_t *it;
+	int idx;
+
+	for(nd = prg; nd != NULL; nd = nd->next) {
+		switch(nd->type) {
+			case PCBQ_EXPR_PROG:
+				fprintf(f, "expression: cartesian product of all iterators\n");
+				break;
+			case PCBQ_RULE:
+				it = nd->data.children->data.iter_ctx;
+				pcb_qry_iter_init(it);
+				fprintf(f, "rule %s\n", nd->data.children->next->data.str);
+				for(n = nd->data.children->next->next, idx = 0; n != NULL; n = n->next)
+					if (n->type == PCBQ_ASSERT)
+						explain_assert(f, n, it, idx++);
+				if (idx == 0)
+					fprintf(f, " <no assert>\n");
+				break;
+			default:
+				/* user functions are planned where they are called from */
+				break;
+		}
+	}
+}
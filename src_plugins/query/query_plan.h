@@ -0,0 +1,66 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  pcb-rnd, interactive printed circuit board design
+ *  Copyright (C) 2024 Tibor 'Igor2' Palinkas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  Contact:
+ *    Project page: http://repo.hu/projects/pcb-rnd
+ *    lead developer: http://repo.hu/projects/pcb-rnd/contact.html
+ *    mailing list: pcb-rnd (at) list.repo.hu (send "subscribe")
+ */
+
+/* Query language - execution planner: decide whether an assert can be
+   evaluated as a spatial join instead of the cartesian product of its
+   iterators */
+
+#ifndef PCB_QUERY_PLAN_H
+#define PCB_QUERY_PLAN_H
+
+#include <stdio.h>
+#include "query.h"
+
+typedef enum pcb_qry_plan_type_e {
+	PCB_QRY_PLAN_CARTESIAN = 0,  /* iterate over all combinations of the active iterators */
+	PCB_QRY_PLAN_BBOX_JOIN       /* two iterators joined by a geometric predicate; candidates come from an rtree */
+} pcb_qry_plan_type_t;
+
+typedef struct pcb_qry_plan_s {
+	pcb_qry_plan_type_t type;
+
+	/* PCB_QRY_PLAN_BBOX_JOIN only: */
+	int outer, inner;        /* iterator (variable) indices; outer > inner so the output order matches the cartesian order */
+	pcb_qry_node_t *pred;    /* the FCALL node of the join predicate */
+	pcb_qry_node_t *bloat;   /* expression of the predicate's bloat argument or NULL if there's none; never depends on iterators */
+} pcb_qry_plan_t;
+
+/* Decide how the expression of an assert node should be executed. Never
+   fails: falls back to PCB_QRY_PLAN_CARTESIAN if no better plan is found.
+   A join is chosen only if the expression can be true only when the join
+   predicate is true (the predicate is on the AND/THUS-condition spine) and
+   the two joined variables are the only active iterators of the assert. */
+void pcb_qry_plan_assert(pcb_qry_node_t *assrt, pcb_qry_plan_t *plan);
+
+/* When 0, pcb_qry_plan_assert() always returns PCB_QRY_PLAN_CARTESIAN; used
+   for comparing the join against the cartesian code. Default is 1. */
+extern int pcb_qry_plan_join;
+
+/* Print the execution plan of each assert of each rule (or the plan of the
+   expression) of a compiled script */
+void pcb_qry_plan_explain(FILE *f, pcb_qry_node_t *prg);
+
+#endif
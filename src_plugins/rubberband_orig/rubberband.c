@@ -59,6 +59,8 @@
 #include "layer_grp.h"
 #include "fgeometry.h"
 #include "search.h"
+#include <genht/htpi.h>
+#include <genht/hash.h>
 
 #include "polygon.h"
 
@@ -109,6 +111,7 @@ typedef struct {
 typedef struct {
 	vtrbli_t lines;
 	vtrbar_t arcs;
+	htpi_t line_idx, arc_idx; /* key: line/arc object; value: index in lines/arcs; may be stale after lines/arcs shrink, checked on lookup */
 } rubber_ctx_t;
 
 static rubber_ctx_t rubber_band_state;
@@ -155,6 +158,25 @@ static int rbe_subc_locked(pcb_any_obj_t *obj)
 	return 1;
 }
 
+/* Returns the rubberband entry of a line or NULL if the line is not attached */
+static pcb_rb_line_t *rubber_band_find(rubber_ctx_t *rbnd, pcb_line_t *Line)
+{
+	htpi_entry_t *e = htpi_getentry(&rbnd->line_idx, Line);
+
+	if ((e == NULL) || (e->value >= rbnd->lines.used) || (rbnd->lines.array[e->value].Line != Line))
+		return NULL;
+	return &rbnd->lines.array[e->value];
+}
+
+static pcb_rb_arc_t *rubber_band_find_arc(rubber_ctx_t *rbnd, pcb_arc_t *Arc)
+{
+	htpi_entry_t *e = htpi_getentry(&rbnd->arc_idx, Arc);
+
+	if ((e == NULL) || (e->value >= rbnd->arcs.used) || (rbnd->arcs.array[e->value].Arc != Arc))
+		return NULL;
+	return &rbnd->arcs.array[e->value];
+}
+
 static rnd_rtree_dir_t rubber_callback(void *cl, void *obj, const rnd_rtree_box_t *box)
 {
 	pcb_line_t *line = (pcb_line_t *)obj;
@@ -163,21 +185,20 @@ static rnd_rtree_dir_t rubber_callback(void *cl, void *obj, const rnd_rtree_box_
 	rubber_ctx_t *rbnd = i->rbnd;
 	double x, y, rad, dist1, dist2;
 	rnd_coord_t t;
-	int n, touches1 = 0, touches2 = 0;
+	int touches1 = 0, touches2 = 0;
 	int have_point1 = 0;
 	int have_point2 = 0;
 
 	t = line->Thickness / 2;
 
 	/* Don't add the line if both ends of it are already in the list. */
-	for(n = 0; (n < rbnd->lines.used) && (have_line == NULL); n++)
-		if (rbnd->lines.array[n].Line == line) {
-			have_line = &rbnd->lines.array[n];
-			if (rbnd->lines.array[n].delta_index[0] >= 0)
-				have_point1 = 1;
-			if (rbnd->lines.array[n].delta_index[1] >= 0)
-				have_point2 = 1;
-		}
+	have_line = rubber_band_find(rbnd, line);
+	if (have_line != NULL) {
+		if (have_line->delta_index[0] >= 0)
+			have_point1 = 1;
+		if (have_line->delta_index[1] >= 0)
+			have_point2 = 1;
+	}
 
 	if (have_point1 && have_point2)
 		return rnd_RTREE_DIR_NOT_FOUND_CONT;
@@ -308,7 +329,7 @@ static rnd_rtree_dir_t rubber_callback_arc(void *cl, void *obj, const rnd_rtree_
 	rnd_coord_t t;
 	rnd_coord_t ex1, ey1;
 	rnd_coord_t ex2, ey2;
-	int n = 0;
+	pcb_rb_arc_t *have_arc;
 	int have_point1 = 0;
 	int have_point2 = 0;
 
@@ -321,11 +342,11 @@ static rnd_rtree_dir_t rubber_callback_arc(void *cl, void *obj, const rnd_rtree_
 		return rnd_RTREE_DIR_NOT_FOUND_CONT;
 
 	/* Don't add the arc if both ends of it are already in the list. */
-	for(n = 0; n < rbnd->arcs.used; n++)
-		if (rbnd->arcs.array[n].Arc == arc) {
-			have_point1 = !(rbnd->arcs.array[n].delta_index[0] < 0);
-			have_point2 = !(rbnd->arcs.array[n].delta_index[1] < 0);
-		}
+	have_arc = rubber_band_find_arc(rbnd, arc);
+	if (have_arc != NULL) {
+		have_point1 = !(have_arc->delta_index[0] < 0);
+		have_point2 = !(have_arc->delta_index[1] < 0);
+	}
 
 	if (have_point1 && have_point2)
 		return rnd_RTREE_DIR_NOT_FOUND_CONT;
@@ -608,6 +629,85 @@ static void CheckArcForRubberbandConnection(rubber_ctx_t *rbnd, pcb_layer_t *Lay
 	}
 }
 
+/* Lines whose endpoint touches an object (arc, polygon, line or padstack):
+   only lines in the object's bounding box can touch it, so the layer's
+   line rtree is searched instead of scanning every line of the layer */
+struct rubber_touch_info {
+	rubber_ctx_t *rbnd;
+	pcb_layer_t *layer;
+	pcb_any_obj_t *obj;
+	rnd_bool clearpoly;
+};
+
+static rnd_bool rubber_touches(struct rubber_touch_info *i, rnd_coord_t x, rnd_coord_t y, rnd_coord_t thick)
+{
+	switch(i->obj->type) {
+		case PCB_OBJ_ARC:  return pcb_is_point_on_arc(x, y, thick, (pcb_arc_t *)i->obj);
+		case PCB_OBJ_POLY: return pcb_poly_is_point_in_p(x, y, thick, (pcb_poly_t *)i->obj);
+		case PCB_OBJ_LINE: return pcb_is_point_on_line(x, y, thick, (pcb_line_t *)i->obj);
+		case PCB_OBJ_PSTK: return pcb_is_point_in_pstk(x, y, thick, (pcb_pstk_t *)i->obj, i->layer);
+		default: break;
+	}
+	return rnd_false;
+}
+
+static rnd_rtree_dir_t rubber_touch_callback(void *cl, void *obj, const rnd_rtree_box_t *box)
+{
+	struct rubber_touch_info *i = cl;
+	pcb_line_t *line = obj;
+	pcb_rb_line_t *have_line;
+	rnd_bool touches1, touches2;
+	rnd_coord_t thick;
+
+	if (PCB_FLAG_TEST(PCB_FLAG_LOCK, line) || rbe_subc_locked((pcb_any_obj_t *)line))
+		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+	if (i->clearpoly && (pcb_layer_flags_(i->layer) & PCB_LYT_COPPER) && PCB_OBJ_HAS_CLEARANCE(line))
+		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+
+	/* Check whether the line is already in the rubberband list. */
+	have_line = rubber_band_find(i->rbnd, line);
+
+	/* Check whether any of the scanned line points touch the passed object */
+	thick = (line->Thickness + 1) / 2;
+	touches1 = rubber_touches(i, line->Point1.X, line->Point1.Y, thick);
+	touches2 = rubber_touches(i, line->Point2.X, line->Point2.Y, thick);
+
+	if (touches1) {
+		if (have_line)
+			have_line->delta_index[0] = 0;
+		else
+			have_line = pcb_rubber_band_create(i->rbnd, i->layer, line, 0, 0);
+	}
+
+	if (touches2) {
+		if (have_line)
+			have_line->delta_index[1] = 0;
+		else
+			have_line = pcb_rubber_band_create(i->rbnd, i->layer, line, 1, 0);
+	}
+
+	return (touches1 || touches2) ? rnd_RTREE_DIR_FOUND_CONT : rnd_RTREE_DIR_NOT_FOUND_CONT;
+}
+
+static void rubber_touch_layer(rubber_ctx_t *rbnd, pcb_layer_t *layer, pcb_any_obj_t *obj, rnd_bool clearpoly)
+{
+	struct rubber_touch_info info;
+	rnd_box_t box;
+
+	if (layer->line_tree == NULL)
+		return;
+
+	info.rbnd = rbnd;
+	info.layer = layer;
+	info.obj = obj;
+	info.clearpoly = clearpoly;
+
+	box = obj->BoundingBox;
+	box.X1--; box.Y1--;
+	box.X2++; box.Y2++;
+	rnd_rtree_search_any(layer->line_tree, (rnd_rtree_box_t *)&box, NULL, rubber_touch_callback, &info, NULL);
+}
+
 /* checks all visible lines which belong to the same group as the passed Arc.
  * If either of the endpoints of the line lays anywhere inside the passed Arc,
  * the scanned line is added to the 'rubberband' list */
@@ -632,44 +732,7 @@ static void CheckEntireArcForRubberbandConnection(rubber_ctx_t *rbnd, pcb_layer_
 			pcb_layer_t *layer = &PCB->Data->Layer[layer_id];
 
 			if (layer->meta.real.vis && ((layer->comb & PCB_LYC_SUB) == comb)) {
-				rnd_coord_t thick;
-
-				/* the following code just stupidly compares the endpoints of the lines */
-				PCB_LINE_LOOP(layer);
-				{
-					pcb_rb_line_t *have_line = NULL;
-					rnd_bool touches1 = rnd_false;
-					rnd_bool touches2 = rnd_false;
-					int l;
-
-					if (PCB_FLAG_TEST(PCB_FLAG_LOCK, line) || rbe_subc_locked((pcb_any_obj_t *)line))
-						continue;
-
-					/* Check whether the line is already in the rubberband list. */
-					for(l = 0; (l < rbnd->lines.used) && (have_line == NULL); l++)
-						if (rbnd->lines.array[l].Line == line)
-							have_line = &rbnd->lines.array[l];
-
-					/* Check whether any of the scanned line points touch the passed line */
-					thick = (line->Thickness + 1) / 2;
-					touches1 = pcb_is_point_on_arc(line->Point1.X, line->Point1.Y, thick, Arc);
-					touches2 = pcb_is_point_on_arc(line->Point2.X, line->Point2.Y, thick, Arc);
-
-					if (touches1) {
-						if (have_line)
-							have_line->delta_index[0] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 0, 0);
-					}
-
-					if (touches2) {
-						if (have_line)
-							have_line->delta_index[1] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 1, 0);
-					}
-				}
-				PCB_END_LOOP;
+				rubber_touch_layer(rbnd, layer, (pcb_any_obj_t *)Arc, rnd_false);
 			}
 		}
 	}
@@ -697,47 +760,7 @@ static void CheckPolygonForRubberbandConnection(rubber_ctx_t *rbnd, pcb_layer_t
 			pcb_layer_t *layer = &PCB->Data->Layer[layer_id];
 
 			if (layer->meta.real.vis && ((layer->comb & PCB_LYC_SUB) == comb)) {
-				rnd_coord_t thick;
-
-				/* the following code just stupidly compares the endpoints
-				 * of the lines
-				 */
-				PCB_LINE_LOOP(layer);
-				{
-					pcb_rb_line_t *have_line = NULL;
-					int touches1 = 0, touches2 = 0;
-					int l;
-
-					if (PCB_FLAG_TEST(PCB_FLAG_LOCK, line) || rbe_subc_locked((pcb_any_obj_t *)line))
-						continue;
-					if ((pcb_layer_flags_(layer) & PCB_LYT_COPPER) && clearpoly && PCB_OBJ_HAS_CLEARANCE(line))
-						continue;
-
-					/* Check whether the line is already in the rubberband list. */
-					for(l = 0; (l < rbnd->lines.used) && (have_line == NULL); l++)
-						if (rbnd->lines.array[l].Line == line)
-							have_line = &rbnd->lines.array[l];
-
-					/* Check whether any of the line points touch the polygon */
-					thick = (line->Thickness + 1) / 2;
-					touches1 = (pcb_poly_is_point_in_p(line->Point1.X, line->Point1.Y, thick, Polygon));
-					touches2 = (pcb_poly_is_point_in_p(line->Point2.X, line->Point2.Y, thick, Polygon));
-
-					if (touches1) {
-						if (have_line)
-							have_line->delta_index[0] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 0, 0);
-					}
-
-					if (touches2) {
-						if (have_line)
-							have_line->delta_index[1] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 1, 0);
-					}
-				}
-				PCB_END_LOOP;
+				rubber_touch_layer(rbnd, layer, (pcb_any_obj_t *)Polygon, clearpoly);
 			}
 		}
 	}
@@ -764,44 +787,7 @@ static void CheckLineForRubberbandConnection(rubber_ctx_t *rbnd, pcb_layer_t *La
 			pcb_layer_t *layer = &PCB->Data->Layer[layer_id];
 
 			if (layer->meta.real.vis && ((layer->comb & PCB_LYC_SUB) == comb)) {
-				rnd_coord_t thick;
-
-				/* the following code just stupidly compares the endpoints of the lines */
-				PCB_LINE_LOOP(layer);
-				{
-					pcb_rb_line_t *have_line = NULL;
-					rnd_bool touches1 = rnd_false;
-					rnd_bool touches2 = rnd_false;
-					int l;
-
-					if (PCB_FLAG_TEST(PCB_FLAG_LOCK, line) || rbe_subc_locked((pcb_any_obj_t *)line))
-						continue;
-
-					/* Check whether the line is already in the rubberband list. */
-					for(l = 0; (l < rbnd->lines.used) && (have_line == NULL); l++)
-						if (rbnd->lines.array[l].Line == line)
-							have_line = &rbnd->lines.array[l];
-
-					/* Check whether any of the scanned line points touch the passed line */
-					thick = (line->Thickness + 1) / 2;
-					touches1 = pcb_is_point_on_line(line->Point1.X, line->Point1.Y, thick, Line);
-					touches2 = pcb_is_point_on_line(line->Point2.X, line->Point2.Y, thick, Line);
-
-					if (touches1) {
-						if (have_line)
-							have_line->delta_index[0] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 0, 0);
-					}
-
-					if (touches2) {
-						if (have_line)
-							have_line->delta_index[1] = 0;
-						else
-							have_line = pcb_rubber_band_create(rbnd, layer, line, 1, 0);
-					}
-				}
-				PCB_END_LOOP;
+				rubber_touch_layer(rbnd, layer, (pcb_any_obj_t *)Line, rnd_false);
 			}
 		}
 	}
@@ -823,44 +809,7 @@ static void CheckPadStackForRubberbandConnection(rubber_ctx_t *rbnd, pcb_pstk_t
 			PCB_COPPER_GROUP_LOOP(PCB->Data, top);
 			{
 				if (layer->meta.real.vis) {
-					rnd_coord_t thick;
-
-					/* the following code just stupidly compares the endpoints of the lines */
-					PCB_LINE_LOOP(layer);
-					{
-						pcb_rb_line_t *have_line = NULL;
-						rnd_bool touches1 = rnd_false;
-						rnd_bool touches2 = rnd_false;
-						int l;
-
-						if (PCB_FLAG_TEST(PCB_FLAG_LOCK, line) || rbe_subc_locked((pcb_any_obj_t *)line))
-							continue;
-
-						/* Check whether the line is already in the rubberband list. */
-						for(l = 0; (l < rbnd->lines.used) && (have_line == NULL); l++)
-							if (rbnd->lines.array[l].Line == line)
-								have_line = &rbnd->lines.array[l];
-
-						/* Check whether any of the scanned line points touch the passed padstack */
-						thick = (line->Thickness + 1) / 2;
-						touches1 = pcb_is_point_in_pstk(line->Point1.X, line->Point1.Y, thick, pstk, layer);
-						touches2 = pcb_is_point_in_pstk(line->Point2.X, line->Point2.Y, thick, pstk, layer);
-
-						if (touches1) {
-							if (have_line)
-								have_line->delta_index[0] = 0;
-							else
-								have_line = pcb_rubber_band_create(rbnd, layer, line, 0, 0);
-						}
-
-						if (touches2) {
-							if (have_line)
-								have_line->delta_index[1] = 0;
-							else
-								have_line = pcb_rubber_band_create(rbnd, layer, line, 1, 0);
-						}
-					}
-					PCB_END_LOOP;
+					rubber_touch_layer(rbnd, layer, (pcb_any_obj_t *)pstk, rnd_false);
 				}
 			}
 			PCB_END_LOOP;
@@ -987,27 +936,23 @@ static void pcb_rubber_band_lookup_rat_lines(rubber_ctx_t *rbnd, int Type, void
    if Layer == 0  it is a rat line; point_number and delta_index is 0 or 1 */
 static pcb_rb_line_t *pcb_rubber_band_create(rubber_ctx_t *rbnd, pcb_layer_t *Layer, pcb_line_t *Line, int point_number, int delta_index)
 {
-	pcb_rb_line_t *ptr = NULL;
-	int n;
+	pcb_rb_line_t *ptr;
 
 	assert((point_number == 0) || (point_number == 1));
 
-	/* do not add any object twice; slow linear search but we expect to have only
-	   a few objects to check. Required for two special cases:
+	/* do not add any object twice. Required for two special cases:
 
 	   1. multiple terminals on the very same coord, the same rat endpoint
 	      found and added multiple times so the move operation is executed
 	      on it multiple times causing the move to end up with multiplied delta.
 	   2. the same rat line is referenced twice: both endpoints are being moved,
 	      e.g. when the rat is within a subc and the subc is moved. */
-	for(n = 0; n < rbnd->lines.used; n++) {
-		if ((rbnd->lines.array[n].Line == Line) && (rbnd->lines.array[n].Layer == Layer)) {
-			ptr = &rbnd->lines.array[n];
-			break;
-		}
-	}
+	ptr = rubber_band_find(rbnd, Line);
+	if ((ptr != NULL) && (ptr->Layer != Layer))
+		ptr = NULL;
 
 	if (ptr == NULL) {
+		htpi_set(&rbnd->line_idx, Line, rbnd->lines.used);
 		ptr = vtrbli_alloc_append(&rbnd->lines, 1);
 		ptr->Layer = Layer;
 		ptr->Line = Line;
@@ -1021,14 +966,10 @@ static pcb_rb_line_t *pcb_rubber_band_create(rubber_ctx_t *rbnd, pcb_layer_t *La
 
 static pcb_rb_arc_t *pcb_rubber_band_create_arc(rubber_ctx_t *rbnd, pcb_layer_t *Layer, pcb_arc_t *Arc, int end, int delta_index)
 {
-	pcb_rb_arc_t *ptr = NULL;
-	int n;
-
-	for(n = 0; (n < rbnd->arcs.used) && (ptr == NULL); n++)
-		if (rbnd->arcs.array[n].Arc == Arc)
-			ptr = &rbnd->arcs.array[n];
+	pcb_rb_arc_t *ptr = rubber_band_find_arc(rbnd, Arc);
 
 	if (ptr == NULL) {
+		htpi_set(&rbnd->arc_idx, Arc, rbnd->arcs.used);
 		ptr = vtrbar_alloc_append(&rbnd->arcs, 1);
 		ptr->Layer = Layer;
 		ptr->Arc = Arc;
@@ -1047,6 +988,8 @@ static void rbe_reset(rnd_design_t *hidlib, void *user_data, int argc, rnd_event
 	rubber_ctx_t *rbnd = user_data;
 	rbnd->lines.used = 0;
 	rbnd->arcs.used = 0;
+	htpi_clear(&rbnd->line_idx);
+	htpi_clear(&rbnd->arc_idx);
 }
 
 static void rbe_move(rnd_design_t *hidlib, void *user_data, int argc, rnd_event_arg_t argv[])
@@ -1466,6 +1409,8 @@ int pplg_check_ver_rubberband_orig(int ver_needed)
 void pplg_uninit_rubberband_orig(void)
 {
 	rnd_event_unbind_allcookie(rubber_cookie);
+	htpi_uninit(&rubber_band_state.line_idx);
+	htpi_uninit(&rubber_band_state.arc_idx);
 	rnd_conf_unreg_fields("plugins/rubberband_orig/");
 }
 
@@ -1473,6 +1418,8 @@ int pplg_init_rubberband_orig(void)
 {
 	void *ctx = &rubber_band_state;
 	RND_API_CHK_VER;
+	htpi_init(&rubber_band_state.line_idx, ptrhash, ptrkeyeq);
+	htpi_init(&rubber_band_state.arc_idx, ptrhash, ptrkeyeq);
 	rnd_event_bind(PCB_EVENT_RUBBER_RESET, rbe_reset, ctx, rubber_cookie);
 	rnd_event_bind(PCB_EVENT_RUBBER_MOVE, rbe_move, ctx, rubber_cookie);
 	rnd_event_bind(PCB_EVENT_RUBBER_MOVE_DRAW, rbe_draw, ctx, rubber_cookie);
@@ -11,6 +11,7 @@ void pointdata_create(point_t *p, pcb_any_obj_t *obj)
 	p->data = calloc(1, sizeof(pointdata_t));
 	pd = p->data;
 	pd->obj = obj;
+	pd->refcnt = 1;
 
 	for (i = 0; i < 4; i++)
 		spoke_init(&pd->spoke[i], i, p);
@@ -6,6 +6,7 @@
 
 struct pointdata_s {
 	pcb_any_obj_t *obj;
+	int refcnt; /* number of board objects triangulated at this point */
 	/* these wirelists are ordered outside-to-inside */
 	/* two lists are used in corner case: when two subsequent wire segments are collinear and
 	 * wires are attached both on the left and on the right side of the point */
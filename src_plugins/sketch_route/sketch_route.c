@@ -32,6 +32,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <librnd/core/plugins.h>
 #include <librnd/core/actions.h>
 #include "board.h"
@@ -67,14 +69,24 @@
 const char *pcb_sketch_route_cookie = "sketch_route plugin";
 
 
+typedef struct {
+	point_t *p;          /* NULL if the object is out of the triangulated area */
+	rnd_coord_t x, y;    /* board coords the object was triangulated at */
+	unsigned long gen;   /* last sync that found the object on the layer */
+} sketch_obj_t;
+
 typedef struct {
 	cdt_t *cdt;
+	pcb_layer_t *layer;
 	htpp_t terminals; /* key - terminal object; value - cdt point */
+	htpp_t objs; /* key - board object triangulated on the layer; value - (sketch_obj_t *) */
+	unsigned long gen;
 	vtwire_t wires;
 	vtewire_t ewires;
 	rnd_rtree_t *spoke_tree;
 	pcb_layer_t *ui_layer_cdt;
 	pcb_layer_t *ui_layer_erbs;
+	unsigned cdt_layer_dirty:1, erbs_layer_dirty:1; /* ui layer is invisible and out of date */
 } sketch_t;
 
 static htip_t sketches;
@@ -147,6 +159,17 @@ static void sketch_update_erbs_layer(sketch_t *sk)
 	}
 }
 
+/* invisible ui layers are redrawn only when they are turned on */
+static void sketch_update_ui_layers(sketch_t *sk)
+{
+	sk->cdt_layer_dirty = !sk->ui_layer_cdt->meta.real.vis;
+	if (!sk->cdt_layer_dirty)
+		sketch_update_cdt_layer(sk);
+	sk->erbs_layer_dirty = !sk->ui_layer_erbs->meta.real.vis;
+	if (!sk->erbs_layer_dirty)
+		sketch_update_erbs_layer(sk);
+}
+
 static void sketch_validate_erbs(sketch_t *sk, ewire_t *ew)
 {
 	/* TODO: check ew spokes against not supported ewires conflicts */
@@ -655,23 +678,18 @@ static wire_t *sketch_insert_wire(sketch_t *sk, wire_t *wire)
 	return new_w;
 }
 
-struct search_info {
-	pcb_layer_t *layer;
-	sketch_t *sk;
-};
+/*** board object tracking ***/
 
-static rnd_rtree_dir_t r_search_cb(void *cl, void *obj_, const rnd_rtree_box_t *box)
+/* Returns 1 and the position if obj is triangulated on the layer of sk */
+static int sketch_obj_pos(sketch_t *sk, pcb_any_obj_t *obj, rnd_coord_t *x, rnd_coord_t *y)
 {
-	pcb_any_obj_t *obj = (pcb_any_obj_t *)obj_;
-	struct search_info *i = (struct search_info *) cl;
-	point_t *point;
-
 	if (obj->type == PCB_OBJ_PSTK) {
 		pcb_pstk_t *pstk = (pcb_pstk_t *) obj;
-		if (pcb_pstk_shape_at(PCB, pstk, i->layer) == NULL)
-			return rnd_RTREE_DIR_NOT_FOUND_CONT;
-		point = cdt_insert_point(i->sk->cdt, pstk->x, -pstk->y);
-		pointdata_create(point, obj);
+		if (pcb_pstk_shape_at(PCB, pstk, sk->layer) == NULL)
+			return 0;
+		*x = pstk->x;
+		*y = pstk->y;
+		return 1;
 	}
 	/* temporary: if a non-padstack obj is _not_ a terminal, then don't triangulate it */
 	/* long term (for non-terminal objects):
@@ -679,31 +697,184 @@ static rnd_rtree_dir_t r_search_cb(void *cl, void *obj_, const rnd_rtree_box_t *
 	 * - polygons should be triangulated on vertices and edges constrained
 	 * - texts - same as polygons for their bbox
 	 * - arcs - same as polygons for their bbox */
-	else if (obj->term != NULL) {
-		coord_t cx, cy;
-		pcb_obj_center(obj, &cx, &cy);
-		point = cdt_insert_point(i->sk->cdt, cx, -cy);
-		pointdata_create(point, obj);
+	if (obj->term != NULL) {
+		pcb_obj_center(obj, x, y);
+		return 1;
 	}
+	return 0;
+}
 
-	if (obj->term != NULL) {
+static void sketch_obj_update_terminal(sketch_t *sk, pcb_any_obj_t *obj, point_t *p)
+{
+	if ((p != NULL) && (obj->term != NULL)) {
 		pcb_subc_t *subc = pcb_obj_parent_subc(obj);
-		if (subc != NULL && subc->refdes != NULL)
-			htpp_insert(&i->sk->terminals, obj, point);
+		if (subc != NULL && subc->refdes != NULL) {
+			htpp_set(&sk->terminals, obj, p);
+			return;
+		}
+	}
+	htpp_pop(&sk->terminals, obj);
+}
+
+/* a point can not be removed from under wires */
+static rnd_bool sketch_point_pinned(point_t *p)
+{
+	pointdata_t *pd = p->data;
+
+	if ((pd->terminal_wires != NULL) || (pd->uturn_wires != NULL) || (pd->attached_wires[0] != NULL) || (pd->attached_wires[1] != NULL))
+		return rnd_true;
+	EDGELIST_FOREACH(e, p->adj_edges)
+		if (e->is_constrained)
+			return rnd_true;
+	EDGELIST_FOREACH_END();
+	return rnd_false;
+}
+
+static point_t *sketch_point_add(sketch_t *sk, pcb_any_obj_t *obj, rnd_coord_t x, rnd_coord_t y)
+{
+	point_t *p = cdt_insert_point(sk->cdt, x, -y);
+
+	if (p == NULL)
+		return NULL;
+	if (p->data == NULL)
+		pointdata_create(p, obj);
+	else { /* another object at the same position */
+		pointdata_t *pd = p->data;
+		if (pd->obj == NULL) /* the point of a removed object kept for its wires */
+			pd->obj = obj;
+		pd->refcnt++;
+	}
+	return p;
+}
+
+/* Returns -1 if the point can not be removed at the moment */
+static int sketch_point_del(sketch_t *sk, pcb_any_obj_t *obj, point_t *p)
+{
+	pointdata_t *pd = p->data;
+
+	if (pd->refcnt > 1) {
+		if (pd->obj == obj) {
+			htpp_entry_t *e;
+			for (e = htpp_first(&sk->objs); e; e = htpp_next(&sk->objs, e)) {
+				if ((e->key != obj) && (((sketch_obj_t *) e->value)->p == p)) {
+					pd->obj = e->key;
+					break;
+				}
+			}
+		}
+		pd->refcnt--;
+		return 0;
 	}
 
+	if (sketch_point_pinned(p))
+		return -1;
+
+	pointdata_free(p);
+	p->data = NULL;
+	cdt_delete_point(sk->cdt, p);
+	return 0;
+}
+
+static void sketch_obj_add(sketch_t *sk, pcb_any_obj_t *obj, rnd_coord_t x, rnd_coord_t y)
+{
+	sketch_obj_t *so = malloc(sizeof(sketch_obj_t));
+
+	so->p = sketch_point_add(sk, obj, x, y);
+	so->x = x;
+	so->y = y;
+	so->gen = sk->gen;
+	htpp_set(&sk->objs, obj, so);
+	sketch_obj_update_terminal(sk, obj, so->p);
+}
+
+typedef struct {
+	sketch_t *sk;
+	int changed;
+} sketch_sync_t;
+
+static rnd_rtree_dir_t sketch_sync_cb(void *cl, void *obj_, const rnd_rtree_box_t *box)
+{
+	pcb_any_obj_t *obj = (pcb_any_obj_t *)obj_;
+	sketch_sync_t *ctx = cl;
+	sketch_t *sk = ctx->sk;
+	sketch_obj_t *so;
+	rnd_coord_t x, y;
+
+	if (!sketch_obj_pos(sk, obj, &x, &y))
+		return rnd_RTREE_DIR_NOT_FOUND_CONT;
+
+	so = htpp_get(&sk->objs, obj);
+	if (so == NULL) {
+		sketch_obj_add(sk, obj, x, y);
+		ctx->changed = 1;
+		return rnd_RTREE_DIR_FOUND_CONT;
+	}
+
+	so->gen = sk->gen;
+	if ((so->x != x) || (so->y != y)) {
+		/* a pinned point stays; the move is retried on the next sync */
+		if ((so->p == NULL) || (sketch_point_del(sk, obj, so->p) == 0)) {
+			so->p = sketch_point_add(sk, obj, x, y);
+			so->x = x;
+			so->y = y;
+			ctx->changed = 1;
+		}
+	}
+	sketch_obj_update_terminal(sk, obj, so->p);
+
 	return rnd_RTREE_DIR_FOUND_CONT;
 }
 
-static void sketch_create_for_layer(sketch_t *sk, pcb_layer_t *layer)
+/* Bring the triangulation in sync with the objects of the layer: only
+   objects created, moved or removed since the last sync are inserted to
+   or deleted from the CDT. Returns non-zero if the CDT changed. */
+static int sketch_sync(sketch_t *sk)
 {
 	rnd_box_t bbox;
-	struct search_info info;
+	sketch_sync_t ctx;
+	htpp_entry_t *e;
+
+	ctx.sk = sk;
+	ctx.changed = 0;
+	sk->gen++;
+
+	bbox.X1 = PCB->hidlib.dwg.X1; bbox.Y1 = PCB->hidlib.dwg.Y1; bbox.X2 = PCB->hidlib.dwg.X2; bbox.Y2 = PCB->hidlib.dwg.Y2;
+	rnd_rtree_search_any(PCB->Data->padstack_tree, (rnd_rtree_box_t *)&bbox, NULL, sketch_sync_cb, &ctx, NULL);
+	rnd_rtree_search_any(sk->layer->line_tree, (rnd_rtree_box_t *)&bbox, NULL, sketch_sync_cb, &ctx, NULL);
+	rnd_rtree_search_any(sk->layer->text_tree, (rnd_rtree_box_t *)&bbox, NULL, sketch_sync_cb, &ctx, NULL);
+	rnd_rtree_search_any(sk->layer->polygon_tree, (rnd_rtree_box_t *)&bbox, NULL, sketch_sync_cb, &ctx, NULL);
+	rnd_rtree_search_any(sk->layer->arc_tree, (rnd_rtree_box_t *)&bbox, NULL, sketch_sync_cb, &ctx, NULL);
+
+	/* objects not found are removed from the layer (the key pointers are not
+	   dereferenced: removed objects may be already freed) */
+	for (e = htpp_first(&sk->objs); e; e = htpp_next(&sk->objs, e)) {
+		sketch_obj_t *so = e->value;
+		if (so->gen == sk->gen)
+			continue;
+		if ((so->p != NULL) && (sketch_point_del(sk, e->key, so->p) != 0)) {
+			/* the point is pinned by wires: it stays in the CDT without an object */
+			pointdata_t *pd = so->p->data;
+			pd->obj = NULL;
+			pd->refcnt = 0;
+		}
+		htpp_pop(&sk->terminals, e->key);
+		htpp_delentry(&sk->objs, e);
+		free(so);
+		ctx.changed = 1;
+	}
+
+	return ctx.changed;
+}
+
+static void sketch_create_for_layer(sketch_t *sk, pcb_layer_t *layer)
+{
 	char name[256];
 
 	sk->cdt = malloc(sizeof(cdt_t));
 	cdt_init(sk->cdt, 0, 0, PCB->hidlib.dwg.X2, -PCB->hidlib.dwg.Y2);
+	sk->layer = layer;
 	htpp_init(&sk->terminals, ptrhash, ptrkeyeq);
+	htpp_init(&sk->objs, ptrhash, ptrkeyeq);
 	sk->wires.elem_constructor = vtwire_constructor;
 	sk->wires.elem_destructor = vtwire_destructor;
 	sk->wires.elem_copy = NULL;
@@ -715,14 +886,7 @@ static void sketch_create_for_layer(sketch_t *sk, pcb_layer_t *layer)
 
 	rnd_rtree_init(sk->spoke_tree = malloc(sizeof(rnd_rtree_t)));
 
-	bbox.X1 = PCB->hidlib.dwg.X1; bbox.Y1 = PCB->hidlib.dwg.Y1; bbox.X2 = PCB->hidlib.dwg.X2; bbox.Y2 = PCB->hidlib.dwg.Y2;
-	info.layer = layer;
-	info.sk = sk;
-	rnd_rtree_search_any(PCB->Data->padstack_tree, (rnd_rtree_box_t *)&bbox, NULL, r_search_cb, &info, NULL);
-	rnd_rtree_search_any(layer->line_tree, (rnd_rtree_box_t *)&bbox, NULL, r_search_cb, &info, NULL);
-	rnd_rtree_search_any(layer->text_tree, (rnd_rtree_box_t *)&bbox, NULL, r_search_cb, &info, NULL);
-	rnd_rtree_search_any(layer->polygon_tree, (rnd_rtree_box_t *)&bbox, NULL, r_search_cb, &info, NULL);
-	rnd_rtree_search_any(layer->arc_tree, (rnd_rtree_box_t *)&bbox, NULL, r_search_cb, &info, NULL);
+	sketch_sync(sk);
 
 	rnd_snprintf(name, sizeof(name), "%s: CDT", layer->name);
 	sk->ui_layer_cdt = pcb_uilayer_alloc(PCB, pcb_sketch_route_cookie, name, &layer->meta.real.color);
@@ -744,6 +908,8 @@ static sketch_t *sketch_alloc()
 
 static void sketch_uninit(sketch_t *sk)
 {
+	htpp_entry_t *e;
+
 	if (sk->cdt != NULL) {
 		VTPOINT_FOREACH(p, &sk->cdt->points)
 			pointdata_free(p);
@@ -755,6 +921,9 @@ static void sketch_uninit(sketch_t *sk)
 	vtwire_uninit(&sk->wires);
 	vtewire_uninit(&sk->ewires);
 	htpp_uninit(&sk->terminals);
+	for (e = htpp_first(&sk->objs); e; e = htpp_next(&sk->objs, e))
+		free(e->value);
+	htpp_uninit(&sk->objs);
 
 	rnd_rtree_uninit(sk->spoke_tree);
 	free(sk->spoke_tree);
@@ -765,8 +934,12 @@ static void sketch_uninit(sketch_t *sk)
 }
 
 
+static void sketches_init();
+
 static sketch_t *sketches_get_sketch_at_layer(pcb_layer_t *layer)
 {
+	if (sketches.table == NULL) /* freed on board change while the tool was active */
+		sketches_init();
 	return htip_getentry(&sketches, pcb_layer_id(PCB->Data, layer))->value;
 }
 
@@ -788,12 +961,56 @@ static void sketches_uninit()
 {
 	htip_entry_t *e;
 
+	if (sketches.table == NULL) /* not initialized or already freed */
+		return;
+
 	for (e = htip_first(&sketches); e; e = htip_next(&sketches, e)) {
 		sketch_uninit(e->value);
 		free(e->value);
 		htip_delentry(&sketches, e);
 	}
 	htip_uninit(&sketches);
+	memset(&sketches, 0, sizeof(sketches));
+}
+
+static void sketch_route_board_edited_ev(rnd_design_t *hidlib, void *user_data, int argc, rnd_event_arg_t argv[])
+{
+	htip_entry_t *e;
+
+	if (htip_length(&sketches) == 0)
+		return;
+
+	for (e = htip_first(&sketches); e; e = htip_next(&sketches, e)) {
+		sketch_t *sk = e->value;
+		if (sketch_sync(sk))
+			sketch_update_ui_layers(sk);
+	}
+}
+
+static void sketch_route_board_changed_ev(rnd_design_t *hidlib, void *user_data, int argc, rnd_event_arg_t argv[])
+{
+	/* sketches refer to the layers and objects of the previous board */
+	sketches_uninit();
+}
+
+static void sketch_route_layervis_ev(rnd_design_t *hidlib, void *user_data, int argc, rnd_event_arg_t argv[])
+{
+	htip_entry_t *e;
+
+	if (htip_length(&sketches) == 0)
+		return;
+
+	for (e = htip_first(&sketches); e; e = htip_next(&sketches, e)) {
+		sketch_t *sk = e->value;
+		if (sk->cdt_layer_dirty && sk->ui_layer_cdt->meta.real.vis) {
+			sketch_update_cdt_layer(sk);
+			sk->cdt_layer_dirty = 0;
+		}
+		if (sk->erbs_layer_dirty && sk->ui_layer_erbs->meta.real.vis) {
+			sketch_update_erbs_layer(sk);
+			sk->erbs_layer_dirty = 0;
+		}
+	}
 }
 
 
@@ -1194,6 +1411,7 @@ int pplg_check_ver_sketch_route(int ver_needed) { return 0; }
 
 void pplg_uninit_sketch_route(void)
 {
+	rnd_event_unbind_allcookie(pcb_sketch_route_cookie);
 	rnd_remove_actions_by_cookie(pcb_sketch_route_cookie);
 	rnd_tool_unreg_by_cookie(pcb_sketch_route_cookie); /* should be done before pcb_tool_uninit, somehow */
 	sketches_uninit();
@@ -1206,5 +1424,9 @@ int pplg_init_sketch_route(void)
 
 	rnd_tool_reg(&tool_skline, pcb_sketch_route_cookie);
 
+	rnd_event_bind(PCB_EVENT_BOARD_EDITED, sketch_route_board_edited_ev, NULL, pcb_sketch_route_cookie);
+	rnd_event_bind(RND_EVENT_DESIGN_SET_CURRENT, sketch_route_board_changed_ev, NULL, pcb_sketch_route_cookie);
+	rnd_event_bind(PCB_EVENT_LAYERVIS_CHANGED, sketch_route_layervis_ev, NULL, pcb_sketch_route_cookie);
+
 	return 0;
 }
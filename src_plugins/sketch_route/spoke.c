@@ -27,11 +27,14 @@ void spoke_uninit(spoke_t *sp)
 
 static void spoke_pos(spoke_t *sp, rnd_coord_t spacing, rnd_coord_t *x, rnd_coord_t *y)
 {
-	rnd_box_t *obj_bbox = &((pointdata_t *) sp->p->data)->obj->bbox_naked;
-	rnd_coord_t half_obj_w, half_obj_h;
+	pcb_any_obj_t *obj = ((pointdata_t *) sp->p->data)->obj;
+	rnd_coord_t half_obj_w = 0, half_obj_h = 0;
 
-	half_obj_w = (obj_bbox->X2 - obj_bbox->X1 + 1) / 2;
-	half_obj_h = (obj_bbox->Y2 - obj_bbox->Y1 + 1) / 2;
+	/* obj is NULL when the object was removed but wires still hold the point */
+	if (obj != NULL) {
+		half_obj_w = (obj->bbox_naked.X2 - obj->bbox_naked.X1 + 1) / 2;
+		half_obj_h = (obj->bbox_naked.Y2 - obj->bbox_naked.Y1 + 1) / 2;
+	}
 
 	switch(sp->dir) {
 	case SPOKE_DIR_1PI4:
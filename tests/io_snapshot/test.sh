@@ -0,0 +1,63 @@
+#!/bin/sh
+
+# Round trip test of the binary board snapshot: a board saved in a snapshot
+# and loaded back must be saved in the same lihata as the original board.
+# The reference is produced in the same run: the original board saved as
+# lihata, so there are no stored .ref files. Missing inputs or outputs fail
+# the test.
+
+ROOT="../.."
+SRC="$ROOT/src"
+GLOBARGS="-c rc/library_search_paths=../tests/RTT/lib -c rc/quiet=1 --gui batch"
+BOARDS="../RTT/flag_colors.lht ../RTT/mech.lht ../RTT/padstack.lht ../RTT/arc_angles.pcb ../RTT/poly_hole.pcb"
+
+if test -x $SRC/pcb-rnd.wrap
+then
+	PCBRND=./pcb-rnd.wrap
+else
+	PCBRND=./pcb-rnd
+fi
+
+# load board $1 and save it in file $2 in format $3
+save_as()
+{
+	local in="`pwd`/$1" out="`pwd`/$2"
+	rm -f "$out"
+	echo "SaveTo(LayoutAs, \"$out\", \"$3\")" | (cd $SRC && $PCBRND $GLOBARGS "$in") >/dev/null 2>&1
+}
+
+fail=0
+for brd in $BOARDS
+do
+	if test ! -f "$brd"
+	then
+		echo "io_snapshot: input board $brd is missing" >&2
+		fail=1
+		continue
+	fi
+	n=`basename $brd`
+	save_as "$brd" "$n.orig.out" "lihata board v9"
+	save_as "$brd" "$n.lhtsnap" "lhtsnap"
+	save_as "$n.lhtsnap" "$n.snap.out" "lihata board v9"
+	for out in "$n.orig.out" "$n.lhtsnap" "$n.snap.out"
+	do
+		if test ! -s "$out"
+		then
+			echo "io_snapshot: $brd: failed to produce $out" >&2
+			fail=1
+		fi
+	done
+	if diff -u "$n.orig.out" "$n.snap.out"
+	then
+		rm "$n.orig.out" "$n.snap.out" "$n.lhtsnap"
+	else
+		fail=1
+	fi
+done
+
+if test $fail = 0
+then
+	echo "io_snapshot:         *** QC PASS ***"
+else
+	exit 1
+fi